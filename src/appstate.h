@@ -6,6 +6,7 @@
 #include <SDL3/SDL_video.h>
 
 #include "common/arena.h"
+#include "renderer/SDL3CLAY.h"
 
 typedef struct {
 
@@ -32,8 +33,13 @@ typedef struct {
 	// Clay State
 	void* clay_memory;
 
+	// Benchmark State
+	bool benchmark;
+	int benchmark_frames;
+	Uint64 benchmark_ticks;
+
 	// Ressources
-	SDL_Texture* img_bg;
+	SDLCLAY_Image* img_bg;
 
 } AppState;
 
@@ -31,6 +31,10 @@
 #include "ui/screens/screen_main.h"
 #include "ui/components/component_debug_button.h"
 
+#define BENCHMARK_FRAMES 240
+// Wait between polls when the UI is idle, since no present throttles the loop
+#define IDLE_FRAME_DELAY_MS 8
+
 void HandleClayErrors(Clay_ErrorData errorData) {
 	SDL_Log("%s", errorData.errorText.chars);
 	switch (errorData.errorType) {
@@ -38,6 +42,58 @@ void HandleClayErrors(Clay_ErrorData errorData) {
 	}
 }
 
+static void ToggleRenderMode() {
+	SDLCLAY_SetRenderMode(
+		SDLCLAY_GetRenderMode() == SDLCLAY_RENDER_MODE_OFFSCREEN
+			? SDLCLAY_RENDER_MODE_DIRECT
+			: SDLCLAY_RENDER_MODE_OFFSCREEN
+	);
+}
+
+static void ToggleShapeMode() {
+	SDLCLAY_SetShapeMode(
+		SDLCLAY_GetShapeMode() == SDLCLAY_SHAPE_MODE_GEOMETRY
+			? SDLCLAY_SHAPE_MODE_STAMPS
+			: SDLCLAY_SHAPE_MODE_GEOMETRY
+	);
+}
+
+// Switch between the text renderers drawing at the exact font size
+static void ToggleTextMode() {
+	SDLCLAY_SetTextMode(
+		SDLCLAY_GetTextMode() == SDLCLAY_TEXT_MODE_GLYPH_ATLAS
+			? SDLCLAY_TEXT_MODE_STRING_CACHE
+			: SDLCLAY_TEXT_MODE_GLYPH_ATLAS
+	);
+}
+
+static void Benchmark_update(AppState* APP, const Uint64 frame_ticks) {
+	APP->benchmark_ticks += frame_ticks;
+	APP->benchmark_frames++;
+
+	if (APP->benchmark_frames < BENCHMARK_FRAMES) {
+		return;
+	}
+
+	const double ms = (double) APP->benchmark_ticks * 1000.0 / (double) SDL_GetPerformanceFrequency() / APP->benchmark_frames;
+	SDL_Log(
+		"Benchmark [%s renderer] %s mode, %s shapes: %.3f ms per frame over %d frames",
+		SDL_GetRendererName(APP->renderer),
+		SDLCLAY_GetRenderMode() == SDLCLAY_RENDER_MODE_DIRECT ? "direct" : "offscreen",
+		SDLCLAY_GetShapeMode() == SDLCLAY_SHAPE_MODE_GEOMETRY ? "geometry" : "stamped",
+		ms,
+		APP->benchmark_frames
+	);
+
+	// Alternate between both render modes, then both shape modes
+	ToggleRenderMode();
+	if (SDLCLAY_GetRenderMode() == SDLCLAY_RENDER_MODE_OFFSCREEN) {
+		ToggleShapeMode();
+	}
+	APP->benchmark_frames = 0;
+	APP->benchmark_ticks = 0;
+}
+
 // ===================================================================================
 //
 // MARK: SDL Main Callbacks
@@ -50,6 +106,21 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char* argv[]) {
 	AppState* APP = AppState_new();
 	*appstate = APP;
 
+	// ===============================
+	// Command Line
+	// --software: use the software renderer
+	// --benchmark: log the render time of each render mode
+	// --scalable-text: draw text from a few shared font sizes, softer but lighter
+	for (int i = 1; i < argc; i++) {
+		if (SDL_strcmp(argv[i], "--software") == 0) {
+			SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+		} else if (SDL_strcmp(argv[i], "--benchmark") == 0) {
+			APP->benchmark = true;
+		} else if (SDL_strcmp(argv[i], "--scalable-text") == 0) {
+			SDLCLAY_SetTextMode(SDLCLAY_TEXT_MODE_SCALABLE);
+		}
+	}
+
 	// ===============================
 	// Initialize SDL
 	if (!SDL_CreateWindowAndRenderer("Hello World", APP->window_width, APP->window_height, SDL_WINDOW_RESIZABLE, &APP->window, &APP->renderer)) {
@@ -61,7 +132,12 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char* argv[]) {
 
 	// ===============================
 	// Init Test Texture
-	APP->img_bg = IMG_LoadTexture(APP->renderer, "assets/bg.jpg");
+	// Scaled down to the output, the full size variant is only built if the window grows
+	int output_width = 0, output_height = 0;
+	SDL_GetCurrentRenderOutputSize(APP->renderer, &output_width, &output_height);
+	SDL_Surface* bg = IMG_Load("assets/bg.jpg");
+	APP->img_bg = SDLCLAY_CreateImageScaled(APP->renderer, bg, output_width, output_height, 2);
+	SDL_DestroySurface(bg);
 
 	// ===============================
 	// Initialize Clay
@@ -79,6 +155,12 @@ SDL_AppResult SDL_AppInit(void** appstate, int argc, char* argv[]) {
 	// ===============================
 	// Initialize SDL3CLAY
 	SDLCLAY_SetAllocator(ml_callback_malloc, ml_callback_free);
+	SDLCLAY_SetOcclusionCulling(true);
+	SDLCLAY_SetDamageRedraw(true);
+	SDLCLAY_SetGlyphWorkers(2, SDLCLAY_GLYPH_POLICY_PLACEHOLDER);
+#ifndef NDEBUG
+	SDLCLAY_SetMeasureVerification(true);
+#endif
 	SDLCLAY_AddFont("assets/Roboto-Regular.ttf", 16);
 	Clay_SetMeasureTextFunction(SDLCLAY_MeasureText, NULL);
 
@@ -98,6 +180,11 @@ SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* event) {
 		case SDL_EVENT_WINDOW_RESIZED:
 			APP->window_width = event->window.data1;
 			APP->window_height = event->window.data2;
+			SDLCLAY_InvalidateFrame();
+			break;
+		case SDL_EVENT_WINDOW_EXPOSED:
+		case SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED:
+			SDLCLAY_InvalidateFrame();
 			break;
 		// ===============================
 		// MOUSE EVENTS
@@ -125,6 +212,15 @@ SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* event) {
 				case SDLK_KP_MINUS:
 					APP->renderer_zoom -= 0.1f;
 					break;
+				case SDLK_F1:
+					ToggleRenderMode();
+					break;
+				case SDLK_F2:
+					ToggleShapeMode();
+					break;
+				case SDLK_F3:
+					ToggleTextMode();
+					break;
 				default:
 					break;
 			}
@@ -150,13 +246,6 @@ SDL_AppResult SDL_AppIterate(void* appstate) {
 		APP->delta = (float) (currentTime - APP->delta_last_time) / 1000.0f;
 		APP->delta_last_time = currentTime;
 
-		// ===============================
-		// SDL Update
-		SDL_SetRenderScale(APP->renderer, APP->renderer_zoom, APP->renderer_zoom);
-		SDL_SetRenderDrawColor(APP->renderer, COLOR_CLAY_EXPLODE(COLOR_DARK));
-		SDL_RenderClear(APP->renderer);
-		SDL_RenderTexture(APP->renderer, APP->img_bg, NULL, NULL);
-
 		// ========================================
 		// Clay Update
 		Clay_SetLayoutDimensions((Clay_Dimensions){(float) APP->window_width, (float) APP->window_height});
@@ -177,8 +266,31 @@ SDL_AppResult SDL_AppIterate(void* appstate) {
 		// ========================================
 		// Clay Render
 		Clay_RenderCommandArray commands = Clay_EndLayout();
+		SDL_SetRenderScale(APP->renderer, APP->renderer_zoom, APP->renderer_zoom);
+
+		// Nothing to draw when the UI is idle, the window keeps the last frame
+		if (!APP->benchmark && SDLCLAY_IsFrameUnchanged(APP->renderer, &commands)) {
+			APP->mouseWheelX = 0;
+			APP->mouseWheelY = 0;
+			SDL_Delay(IDLE_FRAME_DELAY_MS);
+			return SDL_APP_CONTINUE;
+		}
+
+		// ===============================
+		// SDL Update
+		SDL_SetRenderDrawColor(APP->renderer, COLOR_CLAY_EXPLODE(COLOR_DARK));
+		SDL_RenderClear(APP->renderer);
+		SDLCLAY_RenderImage(APP->renderer, APP->img_bg, NULL);
+
+		const Uint64 render_start = SDL_GetPerformanceCounter();
 		SDLCLAY_RenderCommands(APP->renderer, &commands);
 
+		if (APP->benchmark) {
+			// Make the renderer execute the queued commands so they are timed
+			SDL_FlushRenderer(APP->renderer);
+			Benchmark_update(APP, SDL_GetPerformanceCounter() - render_start);
+		}
+
 		// ===============================
 		// SDL FLIP BUFFER
 		SDL_RenderPresent(APP->renderer);
@@ -194,6 +306,7 @@ SDL_AppResult SDL_AppIterate(void* appstate) {
 void SDL_AppQuit(void* appstate, SDL_AppResult result) {
 	AppState* APP = appstate;
 	ScreenManager_end(APP);
+	SDLCLAY_DestroyImage(APP->img_bg);
 	SDLCLAY_Quit();
 	ml_free(APP->clay_memory);
 	ml_free(APP);
@@ -4,480 +4,4419 @@ static SDLCLAY_Fun_Logger SDLCLAY_LOG = SDL_Log;
 static SDLCLAY_Fun_Malloc SDLCLAY_MALLOC = SDL_malloc;
 static SDLCLAY_Fun_Free SDLCLAY_FREE = SDL_free;
 
+static SDLCLAY_TextMode TEXT_MODE = SDLCLAY_TEXT_MODE_GLYPH_ATLAS;
+static SDLCLAY_RenderMode RENDER_MODE = SDLCLAY_RENDER_MODE_OFFSCREEN;
+static float CORNER_TOLERANCE = 0.25f;
+static SDLCLAY_ShapeMode SHAPE_MODE = SDLCLAY_SHAPE_MODE_GEOMETRY;
+static bool OCCLUSION_CULLING = false;
+static bool DAMAGE_REDRAW = false;
+static bool MEASURE_VERIFICATION = false;
+
+// Index of the frame being rendered, incremented by each SDLCLAY_RenderCommands
+static uint64_t FRAME_INDEX = 0;
+static SDLCLAY_Stats STATS = {0};
+
+// ===================================================================================
+// MARK: FONTS
+// ===================================================================================
+
+typedef struct FontSize {
+	float size;
+	TTF_Font* ttf_font;
+	// Frame the size was last requested in, closed by Fonts_trim once idle
+	uint64_t last_used;
+} FontSize;
+
+typedef struct Font {
+	// Font opened by SDLCLAY_AddFont or given to SDLCLAY_AddFontRaw
+	TTF_Font* base;
+	float base_size;
+	// Whether base was opened by SDLCLAY_AddFont and must be closed with the registry
+	bool owned;
+	// Content of the font file, loaded once and shared by every size opened from it.
+	// NULL for fonts added with SDLCLAY_AddFontRaw, their sizes are copies of base.
+	void* data;
+	size_t data_size;
+	// Other sizes sorted by size
+	FontSize* sizes;
+	int size_count;
+	int size_capacity;
+	// Index of the last size returned, text mostly comes in runs of a same size
+	int last_size;
+} Font;
+
+/**
+ * Registry of the fonts, indexed by font id
+ */
+static struct Fonts {
+	Font* fonts;
+	int count;
+	int capacity;
+	// Serializes opening and closing fonts, FreeType requires it once glyph workers run
+	SDL_Mutex* library_lock;
+} FONTS = {0};
+
+static void Fonts_lock() {
+	if (FONTS.library_lock != NULL) {
+		SDL_LockMutex(FONTS.library_lock);
+	}
+}
+
+static void Fonts_unlock() {
+	if (FONTS.library_lock != NULL) {
+		SDL_UnlockMutex(FONTS.library_lock);
+	}
+}
+
+static bool Fonts_setThreaded(const bool threaded) {
+	if (threaded && FONTS.library_lock == NULL) {
+		FONTS.library_lock = SDL_CreateMutex();
+		return FONTS.library_lock != NULL;
+	}
+	if (!threaded && FONTS.library_lock != NULL) {
+		SDL_DestroyMutex(FONTS.library_lock);
+		FONTS.library_lock = NULL;
+	}
+	return true;
+}
+
+static bool SDLCLAY_GrowBuffer(void** buffer, int* capacity, const int required, const size_t element_size) {
+	if (required <= *capacity) {
+		return true;
+	}
+
+	int new_capacity = *capacity > 0 ? *capacity : 8;
+	while (new_capacity < required) {
+		new_capacity *= 2;
+	}
+
+	void* new_buffer = SDLCLAY_MALLOC((size_t) new_capacity * element_size);
+	if (new_buffer == NULL) {
+		SDLCLAY_LOG("Failed to grow buffer to %d elements", new_capacity);
+		return false;
+	}
+
+	if (*buffer != NULL) {
+		SDL_memcpy(new_buffer, *buffer, (size_t) *capacity * element_size);
+		SDLCLAY_FREE(*buffer);
+	}
+
+	*buffer = new_buffer;
+	*capacity = new_capacity;
+	return true;
+}
+
+static void Fonts_free() {
+	for (int i = 0; i < FONTS.count; i++) {
+		Font* font = &FONTS.fonts[i];
+		for (int j = 0; j < font->size_count; j++) {
+			TTF_CloseFont(font->sizes[j].ttf_font);
+		}
+		SDLCLAY_FREE(font->sizes);
+		if (font->owned) {
+			TTF_CloseFont(font->base);
+		}
+		// After every font reading it is closed
+		if (font->data != NULL) {
+			SDLCLAY_FREE(font->data);
+		}
+	}
+	SDLCLAY_FREE(FONTS.fonts);
+	SDL_memset(&FONTS, 0, sizeof(FONTS));
+}
+
+/**
+ * Close the sizes not requested for SDLCLAY_FONT_SIZE_IDLE_FRAMES frames, the base sizes stay open
+ */
+static void Fonts_trim() {
+	int size_count = 0;
+	for (int i = 0; i < FONTS.count; i++) {
+		Font* font = &FONTS.fonts[i];
+		int kept = 0;
+		for (int j = 0; j < font->size_count; j++) {
+			if (FRAME_INDEX - font->sizes[j].last_used > SDLCLAY_FONT_SIZE_IDLE_FRAMES) {
+				Fonts_lock();
+				TTF_CloseFont(font->sizes[j].ttf_font);
+				Fonts_unlock();
+				STATS.font_size_evictions++;
+			} else {
+				font->sizes[kept++] = font->sizes[j];
+			}
+		}
+		font->size_count = kept;
+		font->last_size = 0;
+		size_count += 1 + kept;
+	}
+	STATS.font_sizes = size_count;
+}
+
+static bool SDLCLAY_IsValidFontSize(const float size) {
+	return size > 0 && size <= (float) SDLCLAY_FONT_MAX_SIZE;
+}
+
+/**
+ * Open a font from bytes that must outlive it, nothing is copied
+ */
+static TTF_Font* SDLCLAY_OpenFontMemory(const void* data, const size_t data_size, const float size) {
+	SDL_IOStream* stream = SDL_IOFromConstMem(data, data_size);
+	if (stream == NULL) {
+		return NULL;
+	}
+
+	Fonts_lock();
+	TTF_Font* font = TTF_OpenFontIO(stream, true, size);
+	Fonts_unlock();
+	return font;
+}
+
+/**
+ * Read a whole file into a buffer from the allocator hooks
+ * @return Buffer to release with SDLCLAY_FREE, NULL on failure
+ */
+static void* SDLCLAY_LoadFile(const char* path, size_t* size) {
+	SDL_IOStream* stream = SDL_IOFromFile(path, "rb");
+	if (stream == NULL) {
+		return NULL;
+	}
+
+	const Sint64 stream_size = SDL_GetIOSize(stream);
+	void* data = stream_size > 0 ? SDLCLAY_MALLOC((size_t) stream_size) : NULL;
+	if (data != NULL && SDL_ReadIO(stream, data, (size_t) stream_size) != (size_t) stream_size) {
+		SDLCLAY_FREE(data);
+		data = NULL;
+	}
+	SDL_CloseIO(stream);
+
+	*size = data != NULL ? (size_t) stream_size : 0;
+	return data;
+}
+
+int SDLCLAY_AddFont(const char * font_path, const float init_size) {
+	if (font_path == NULL || !SDLCLAY_IsValidFontSize(init_size)) {
+		SDLCLAY_LOG("Invalid font path:\"%s\" or size: %g", font_path, (double) init_size);
+		return -1;
+	}
+
+	size_t data_size = 0;
+	void* data = SDLCLAY_LoadFile(font_path, &data_size);
+	TTF_Font* font = data != NULL ? SDLCLAY_OpenFontMemory(data, data_size, init_size) : NULL;
+
+	if (font == NULL) {
+		SDLCLAY_LOG("Failed to load font: %s, %s", font_path, SDL_GetError());
+		if (data != NULL) {
+			SDLCLAY_FREE(data);
+		}
+		return -1;
+	}
+
+	const int font_index = SDLCLAY_AddFontRaw(font, init_size);
+	if (font_index < 0) {
+		TTF_CloseFont(font);
+		SDLCLAY_FREE(data);
+		return -1;
+	}
+
+	FONTS.fonts[font_index].owned = true;
+	FONTS.fonts[font_index].data = data;
+	FONTS.fonts[font_index].data_size = data_size;
+	return font_index;
+}
+
+int SDLCLAY_AddFontRaw(TTF_Font * font, const float init_size) {
+	if (font == NULL || !SDLCLAY_IsValidFontSize(init_size)) {
+		SDLCLAY_LOG("Invalid font %p or size: %g", font, (double) init_size);
+		return -1;
+	}
+
+	if (!SDLCLAY_GrowBuffer((void**) &FONTS.fonts, &FONTS.capacity, FONTS.count + 1, sizeof(Font))) {
+		return -1;
+	}
+
+	Font* new_font = &FONTS.fonts[FONTS.count];
+	SDL_memset(new_font, 0, sizeof(Font));
+	new_font->base = font;
+	new_font->base_size = init_size;
+
+	return FONTS.count++;
+}
+
+TTF_Font* SDLCLAY_GetFont(const int font_index, const float size) {
+	if (font_index < 0 || font_index >= FONTS.count || !SDLCLAY_IsValidFontSize(size)) {
+		SDLCLAY_LOG("Invalid font index: %d or size: %g", font_index, (double) size);
+		return NULL;
+	}
+
+	Font* font = &FONTS.fonts[font_index];
+	if (size == font->base_size) {
+		return font->base;
+	}
+
+	if (font->last_size < font->size_count && font->sizes[font->last_size].size == size) {
+		font->sizes[font->last_size].last_used = FRAME_INDEX;
+		return font->sizes[font->last_size].ttf_font;
+	}
+
+	int low = 0, high = font->size_count;
+	while (low < high) {
+		const int middle = (low + high) / 2;
+		if (font->sizes[middle].size < size) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+
+	if (low < font->size_count && font->sizes[low].size == size) {
+		font->last_size = low;
+		font->sizes[low].last_used = FRAME_INDEX;
+		return font->sizes[low].ttf_font;
+	}
+
+	if (!SDLCLAY_GrowBuffer((void**) &font->sizes, &font->size_capacity, font->size_count + 1, sizeof(FontSize))) {
+		return NULL;
+	}
+
+	TTF_Font* ttf_font = NULL;
+	if (font->data != NULL) {
+		ttf_font = SDLCLAY_OpenFontMemory(font->data, font->data_size, size);
+	} else {
+		Fonts_lock();
+		ttf_font = TTF_CopyFont(font->base);
+		if (ttf_font != NULL && !TTF_SetFontSize(ttf_font, size)) {
+			TTF_CloseFont(ttf_font);
+			ttf_font = NULL;
+		}
+		Fonts_unlock();
+	}
+
+	if (ttf_font == NULL) {
+		SDLCLAY_LOG("Failed to open font %d at size %g: %s", font_index, (double) size, SDL_GetError());
+		return NULL;
+	}
+
+	SDL_memmove(&font->sizes[low + 1], &font->sizes[low], (size_t) (font->size_count - low) * sizeof(FontSize));
+	font->sizes[low] = (FontSize){size, ttf_font, FRAME_INDEX};
+	font->size_count++;
+	font->last_size = low;
+	return ttf_font;
+}
+
+// ===================================================================================
+// MARK: METRICS
+// ===================================================================================
+
+#define SDLCLAY_ASCII_FIRST 32
+#define SDLCLAY_ASCII_LAST 126
+
+/**
+ * Line height and printable ASCII advances of a font size, with the kerning of the
+ * ASCII pairs met so far, so measuring ASCII words does not call into SDL_ttf
+ */
+typedef struct FontMetrics {
+	bool used;
+	int font_id;
+	float size;
+	int height;
+	// Advance of each printable character, -1 when the font cannot tell
+	int advances[SDLCLAY_ASCII_LAST - SDLCLAY_ASCII_FIRST + 1];
+	// Horizontal extent of the pixels of each printable character from its pen position
+	int ink_left[SDLCLAY_ASCII_LAST - SDLCLAY_ASCII_FIRST + 1];
+	int ink_right[SDLCLAY_ASCII_LAST - SDLCLAY_ASCII_FIRST + 1];
+	// Direct mapped, pairs are first << 8 | second and 0 when empty
+	uint16_t kerning_pairs[SDLCLAY_KERNING_CACHE_SIZE];
+	int kerning[SDLCLAY_KERNING_CACHE_SIZE];
+} FontMetrics;
+
+static FontMetrics METRICS_CACHE[SDLCLAY_METRICS_CACHE_SIZE] = {0};
+
+static FontMetrics* FontMetrics_get(const int font_id, const float size, TTF_Font* font) {
+	uint32_t bits = 0;
+	SDL_memcpy(&bits, &size, sizeof(bits));
+	const uint32_t index = ((uint32_t) font_id * 0x9E3779B1u ^ bits * 0x85EBCA77u) % SDLCLAY_METRICS_CACHE_SIZE;
+
+	FontMetrics* metrics = &METRICS_CACHE[index];
+	if (metrics->used && metrics->font_id == font_id && metrics->size == size) {
+		return metrics;
+	}
+
+	metrics->used = true;
+	metrics->font_id = font_id;
+	metrics->size = size;
+	metrics->height = TTF_GetFontHeight(font);
+	for (int c = SDLCLAY_ASCII_FIRST; c <= SDLCLAY_ASCII_LAST; c++) {
+		const int index = c - SDLCLAY_ASCII_FIRST;
+		int min_x = 0, max_x = 0, advance = 0;
+		metrics->advances[index] = TTF_GetGlyphMetrics(font, (Uint32) c, &min_x, &max_x, NULL, NULL, &advance)
+			? advance
+			: -1;
+		metrics->ink_left[index] = min_x;
+		metrics->ink_right[index] = max_x;
+	}
+	SDL_memset(metrics->kerning_pairs, 0, sizeof(metrics->kerning_pairs));
+
+	return metrics;
+}
+
+static int FontMetrics_kerning(FontMetrics* metrics, TTF_Font* font, const int previous, const int current) {
+	const uint16_t pair = (uint16_t) (previous << 8 | current);
+	const uint32_t slot = ((uint32_t) previous * 31u + (uint32_t) current) % SDLCLAY_KERNING_CACHE_SIZE;
+
+	if (metrics->kerning_pairs[slot] != pair) {
+		int kerning = 0;
+		TTF_GetGlyphKerning(font, (Uint32) previous, (Uint32) current, &kerning);
+		metrics->kerning_pairs[slot] = pair;
+		metrics->kerning[slot] = kerning;
+	}
+
+	return metrics->kerning[slot];
+}
+
+/**
+ * Width of a printable ASCII slice from the same pen moves GlyphAtlas_renderText draws with.
+ * Like TTF_MeasureString, it spans from the leftmost to the rightmost of the final pen position
+ * and the pixels of the glyphs, so overhanging glyphs widen it.
+ * @return false if the slice has other characters and must be measured by SDL_ttf
+ */
+static bool FontMetrics_measureAscii(FontMetrics* metrics, TTF_Font* font, const Clay_StringSlice text, int* width) {
+	int pen = 0;
+	int previous = 0;
+	int min_x = 0, max_x = 0;
+
+	for (int i = 0; i < text.length; i++) {
+		const int c = (unsigned char) text.chars[i];
+		if (c < SDLCLAY_ASCII_FIRST || c > SDLCLAY_ASCII_LAST || metrics->advances[c - SDLCLAY_ASCII_FIRST] < 0) {
+			return false;
+		}
+
+		const int index = c - SDLCLAY_ASCII_FIRST;
+		if (previous != 0) {
+			pen += FontMetrics_kerning(metrics, font, previous, c);
+		}
+		min_x = SDL_min(min_x, pen + metrics->ink_left[index]);
+		max_x = SDL_max(max_x, pen + metrics->ink_right[index]);
+		pen += metrics->advances[index];
+		previous = c;
+	}
+
+	*width = SDL_max(max_x, pen) - min_x;
+	return true;
+}
+
+/**
+ * Size glyphs are rasterized at for a font size. In SDLCLAY_TEXT_MODE_SCALABLE it is the power
+ * of two at or above it, clamped to SDLCLAY_SCALABLE_TEXT_MIN_SIZE..SDLCLAY_SCALABLE_TEXT_MAX_SIZE,
+ * so nearby sizes share one font instance and its glyphs.
+ */
+static uint16_t SDLCLAY_RasterSize(const uint16_t font_size) {
+	if (TEXT_MODE != SDLCLAY_TEXT_MODE_SCALABLE) {
+		return font_size;
+	}
+
+	int size = SDLCLAY_SCALABLE_TEXT_MIN_SIZE;
+	while (size < font_size && size < SDLCLAY_SCALABLE_TEXT_MAX_SIZE) {
+		size *= 2;
+	}
+	return (uint16_t) size;
+}
+
+Clay_Dimensions SDLCLAY_MeasureText(
+	Clay_StringSlice text,
+	Clay_TextElementConfig* config,
+	void* userData
+) {
+	const uint16_t raster_size = SDLCLAY_RasterSize(config->fontSize);
+	TTF_Font* font = SDLCLAY_GetFont(config->fontId, raster_size);
+	if (font == NULL) {
+		return (Clay_Dimensions){0};
+	}
+
+	FontMetrics* metrics = FontMetrics_get(config->fontId, raster_size, font);
+	int width = 0;
+
+	if (!FontMetrics_measureAscii(metrics, font, text, &width)) {
+		TTF_MeasureString(font, text.chars, (size_t) text.length, 0, &width, NULL);
+	} else if (MEASURE_VERIFICATION) {
+		int expected = 0;
+		TTF_MeasureString(font, text.chars, (size_t) text.length, 0, &expected, NULL);
+		if (expected != width) {
+			SDLCLAY_LOG(
+				"Measured \"%.*s\" (font %d, size %d) %d wide instead of %d",
+				text.length, text.chars, config->fontId, raster_size, width, expected
+			);
+		}
+	}
+
+	// Scalable text is laid out with the metrics of its raster size scaled down
+	const float scale = (float) config->fontSize / (float) raster_size;
+	const Clay_Dimensions result = {
+		.height = (float) metrics->height * scale,
+		.width = (float) width * scale,
+	};
+
+	return result;
+}
+
+void SDLCLAY_SetMeasureVerification(const bool enabled) {
+	MEASURE_VERIFICATION = enabled;
+}
+
+// ===================================================================================
+// MARK: BATCH
+// ===================================================================================
+
+/**
+ * Vertices and indices of every shape tessellated during a frame. Reset at the start
+ * of each SDLCLAY_RenderCommands and kept across frames, so once it reached its
+ * high-water mark steady-state frames do not allocate.
+ */
+static struct GeometryArena {
+	SDL_Vertex* vertices;
+	int* indices;
+	int vertex_count;
+	int index_count;
+	int vertex_capacity;
+	int index_capacity;
+	int vertex_high_water;
+	int index_high_water;
+} GEOMETRY_ARENA = {0};
+
+/**
+ * Pending draw call, the arena vertices and indices sharing the same texture since
+ * the last flush. Its indices are relative to its first vertex.
+ */
+static struct GeometryBatch {
+	SDL_Texture* texture;
+	int first_vertex;
+	int first_index;
+} GEOMETRY_BATCH = {0};
+
+static void GeometryArena_reset() {
+	GEOMETRY_ARENA.vertex_count = 0;
+	GEOMETRY_ARENA.index_count = 0;
+	GEOMETRY_BATCH.first_vertex = 0;
+	GEOMETRY_BATCH.first_index = 0;
+}
+
+static void GeometryBatch_flush(SDL_Renderer* renderer) {
+	const int index_count = GEOMETRY_ARENA.index_count - GEOMETRY_BATCH.first_index;
+
+	if (index_count > 0) {
+		STATS.draw_calls++;
+		// SDL checks every vertex it is given, only pass those of the batch
+		SDL_RenderGeometry(
+			renderer,
+			GEOMETRY_BATCH.texture,
+			&GEOMETRY_ARENA.vertices[GEOMETRY_BATCH.first_vertex],
+			GEOMETRY_ARENA.vertex_count - GEOMETRY_BATCH.first_vertex,
+			&GEOMETRY_ARENA.indices[GEOMETRY_BATCH.first_index],
+			index_count
+		);
+	}
+
+	GEOMETRY_BATCH.first_vertex = GEOMETRY_ARENA.vertex_count;
+	GEOMETRY_BATCH.first_index = GEOMETRY_ARENA.index_count;
+}
+
+/**
+ * Make room for vertex_count vertices and index_count indices drawn with texture,
+ * flushing the pending geometry first if it uses another texture.
+ * Write them at GeometryBatch_vertices and GeometryBatch_indices then call GeometryBatch_commit.
+ *
+ * @return Index of the first reserved vertex in the batch, or -1 on allocation failure
+ */
+static int GeometryBatch_reserve(
+	SDL_Renderer* renderer,
+	SDL_Texture* texture,
+	const int vertex_count,
+	const int index_count
+) {
+	if (GEOMETRY_BATCH.texture != texture) {
+		GeometryBatch_flush(renderer);
+		GEOMETRY_BATCH.texture = texture;
+	}
+
+	const int required_vertices = GEOMETRY_ARENA.vertex_count + vertex_count;
+	const int required_indices = GEOMETRY_ARENA.index_count + index_count;
+	if (required_vertices > GEOMETRY_ARENA.vertex_capacity || required_indices > GEOMETRY_ARENA.index_capacity) {
+		STATS.geometry_allocations++;
+	}
+
+	if (
+		!SDLCLAY_GrowBuffer((void**) &GEOMETRY_ARENA.vertices, &GEOMETRY_ARENA.vertex_capacity, required_vertices, sizeof(SDL_Vertex)) ||
+		!SDLCLAY_GrowBuffer((void**) &GEOMETRY_ARENA.indices, &GEOMETRY_ARENA.index_capacity, required_indices, sizeof(int))
+	) {
+		return -1;
+	}
+
+	return GEOMETRY_ARENA.vertex_count - GEOMETRY_BATCH.first_vertex;
+}
+
+static SDL_Vertex* GeometryBatch_vertices() {
+	return &GEOMETRY_ARENA.vertices[GEOMETRY_ARENA.vertex_count];
+}
+
+static int* GeometryBatch_indices() {
+	return &GEOMETRY_ARENA.indices[GEOMETRY_ARENA.index_count];
+}
+
+/**
+ * Append geometry written after GeometryBatch_reserve, with indices
+ * relative to the first reserved vertex
+ */
+static void GeometryBatch_commit(const int vertex_count, const int index_count) {
+	const int base = GEOMETRY_ARENA.vertex_count - GEOMETRY_BATCH.first_vertex;
+	int* indices = GeometryBatch_indices();
+	for (int i = 0; i < index_count; i++) {
+		indices[i] += base;
+	}
+
+	GEOMETRY_ARENA.vertex_count += vertex_count;
+	GEOMETRY_ARENA.index_count += index_count;
+	GEOMETRY_ARENA.vertex_high_water = SDL_max(GEOMETRY_ARENA.vertex_high_water, GEOMETRY_ARENA.vertex_count);
+	GEOMETRY_ARENA.index_high_water = SDL_max(GEOMETRY_ARENA.index_high_water, GEOMETRY_ARENA.index_count);
+}
+
+static void GeometryBatch_pushQuad(
+	const SDL_FRect dst,
+	const SDL_FRect uv,
+	const SDL_FColor color
+) {
+	SDL_Vertex* vertices = GeometryBatch_vertices();
+	int* indices = GeometryBatch_indices();
+
+	vertices[0] = (SDL_Vertex){{dst.x, dst.y}, color, {uv.x, uv.y}};
+	vertices[1] = (SDL_Vertex){{dst.x + dst.w, dst.y}, color, {uv.x + uv.w, uv.y}};
+	vertices[2] = (SDL_Vertex){{dst.x + dst.w, dst.y + dst.h}, color, {uv.x + uv.w, uv.y + uv.h}};
+	vertices[3] = (SDL_Vertex){{dst.x, dst.y + dst.h}, color, {uv.x, uv.y + uv.h}};
+
+	indices[0] = 0;
+	indices[1] = 1;
+	indices[2] = 2;
+	indices[3] = 0;
+	indices[4] = 2;
+	indices[5] = 3;
+
+	GeometryBatch_commit(4, 6);
+}
+
+static void GeometryBatch_free() {
+	SDLCLAY_FREE(GEOMETRY_ARENA.vertices);
+	SDLCLAY_FREE(GEOMETRY_ARENA.indices);
+	SDL_memset(&GEOMETRY_ARENA, 0, sizeof(GEOMETRY_ARENA));
+	SDL_memset(&GEOMETRY_BATCH, 0, sizeof(GEOMETRY_BATCH));
+}
+
+// ===================================================================================
+// MARK: GLYPH ATLAS
+// ===================================================================================
+
+// Transparent pixels around each glyph, with the pixel AtlasPage_pack leaves between
+// areas glyph pixels are at least 2 pixels apart for linear filtering
+#define SDLCLAY_GLYPH_BORDER 1
+
+typedef struct AtlasPage {
+	SDL_Texture* texture;
+	// Width and height of the texture
+	int size;
+	int shelf_x;
+	int shelf_y;
+	int shelf_height;
+} AtlasPage;
+
+typedef struct Glyph {
+	uint32_t codepoint;
+	uint16_t font_id;
+	uint16_t font_size;
+	// Page holding the glyph pixels, -1 for glyphs without any ink (spaces)
+	int page;
+	SDL_Rect src;
+	int offset_x;
+	int advance;
+	// Rasterizing on a glyph worker, drawn as a placeholder until uploaded
+	bool pending;
+	bool used;
+} Glyph;
+
+static struct GlyphAtlas {
+	SDL_Renderer* renderer;
+	AtlasPage pages[SDLCLAY_GLYPH_ATLAS_MAX_PAGES];
+	int page_count;
+	Glyph* glyphs;
+	int glyph_count;
+	int glyph_capacity;
+	// Filtering of the pages, linear in SDLCLAY_TEXT_MODE_SCALABLE
+	SDL_ScaleMode scale_mode;
+} GLYPH_ATLAS = {0};
+
+/**
+ * Reserve a w*h area in the page using a shelf packer
+ * @return true if the page had room for it
+ */
+static bool AtlasPage_pack(AtlasPage* page, const int w, const int h, SDL_Rect* out_rect) {
+	const int padded_w = w + 1;
+	const int padded_h = h + 1;
+
+	if (page->shelf_x + padded_w > page->size) {
+		page->shelf_y += page->shelf_height;
+		page->shelf_x = 0;
+		page->shelf_height = 0;
+	}
+
+	if (padded_w > page->size || page->shelf_y + padded_h > page->size) {
+		return false;
+	}
+
+	*out_rect = (SDL_Rect){page->shelf_x, page->shelf_y, w, h};
+	page->shelf_x += padded_w;
+	page->shelf_height = SDL_max(page->shelf_height, padded_h);
+	return true;
+}
+
+static uint32_t GlyphAtlas_hash(const uint16_t font_id, const uint16_t font_size, const uint32_t codepoint) {
+	uint32_t hash = codepoint * 0x9E3779B1u;
+	hash ^= ((uint32_t) font_id << 16 | font_size) * 0x85EBCA77u;
+	hash ^= hash >> 15;
+	return hash;
+}
+
+static void GlyphAtlas_clearGlyphs() {
+	if (GLYPH_ATLAS.glyphs != NULL) {
+		SDL_memset(GLYPH_ATLAS.glyphs, 0, (size_t) GLYPH_ATLAS.glyph_capacity * sizeof(Glyph));
+	}
+	GLYPH_ATLAS.glyph_count = 0;
+}
+
+static void GlyphAtlas_free() {
+	for (int i = 0; i < GLYPH_ATLAS.page_count; i++) {
+		SDL_DestroyTexture(GLYPH_ATLAS.pages[i].texture);
+	}
+	SDLCLAY_FREE(GLYPH_ATLAS.glyphs);
+	// The filtering follows the text mode, not the pages
+	const SDL_ScaleMode scale_mode = GLYPH_ATLAS.scale_mode;
+	SDL_memset(&GLYPH_ATLAS, 0, sizeof(GLYPH_ATLAS));
+	GLYPH_ATLAS.scale_mode = scale_mode;
+}
+
+static Glyph* GlyphAtlas_find(const uint16_t font_id, const uint16_t font_size, const uint32_t codepoint) {
+	if (GLYPH_ATLAS.glyph_capacity == 0) {
+		return NULL;
+	}
+
+	const uint32_t mask = (uint32_t) GLYPH_ATLAS.glyph_capacity - 1;
+	uint32_t index = GlyphAtlas_hash(font_id, font_size, codepoint) & mask;
+
+	while (GLYPH_ATLAS.glyphs[index].used) {
+		Glyph* glyph = &GLYPH_ATLAS.glyphs[index];
+		if (glyph->codepoint == codepoint && glyph->font_id == font_id && glyph->font_size == font_size) {
+			return glyph;
+		}
+		index = (index + 1) & mask;
+	}
+
+	return NULL;
+}
+
+static Glyph* GlyphAtlas_insert(const Glyph glyph) {
+	// Keep the load factor under 1/2
+	if ((GLYPH_ATLAS.glyph_count + 1) * 2 > GLYPH_ATLAS.glyph_capacity) {
+		const int old_capacity = GLYPH_ATLAS.glyph_capacity;
+		Glyph* old_glyphs = GLYPH_ATLAS.glyphs;
+		const int new_capacity = old_capacity > 0 ? old_capacity * 2 : 512;
+
+		Glyph* new_glyphs = SDLCLAY_MALLOC((size_t) new_capacity * sizeof(Glyph));
+		if (new_glyphs == NULL) {
+			return NULL;
+		}
+		SDL_memset(new_glyphs, 0, (size_t) new_capacity * sizeof(Glyph));
+
+		GLYPH_ATLAS.glyphs = new_glyphs;
+		GLYPH_ATLAS.glyph_capacity = new_capacity;
+		GLYPH_ATLAS.glyph_count = 0;
+
+		for (int i = 0; i < old_capacity; i++) {
+			if (old_glyphs[i].used) {
+				GlyphAtlas_insert(old_glyphs[i]);
+			}
+		}
+		SDLCLAY_FREE(old_glyphs);
+	}
+
+	const uint32_t mask = (uint32_t) GLYPH_ATLAS.glyph_capacity - 1;
+	uint32_t index = GlyphAtlas_hash(glyph.font_id, glyph.font_size, glyph.codepoint) & mask;
+	while (GLYPH_ATLAS.glyphs[index].used) {
+		index = (index + 1) & mask;
+	}
+
+	GLYPH_ATLAS.glyphs[index] = glyph;
+	GLYPH_ATLAS.glyphs[index].used = true;
+	GLYPH_ATLAS.glyph_count++;
+	return &GLYPH_ATLAS.glyphs[index];
+}
+
+/**
+ * Find room for a w*h glyph in the existing pages, opening a new page if needed.
+ * When every page is full the whole atlas is recycled.
+ *
+ * @return Page index or -1 if the glyph does not fit at all
+ */
+static int GlyphAtlas_allocate(SDL_Renderer* renderer, const int w, const int h, SDL_Rect* out_rect) {
+	for (int i = 0; i < GLYPH_ATLAS.page_count; i++) {
+		if (AtlasPage_pack(&GLYPH_ATLAS.pages[i], w, h, out_rect)) {
+			return i;
+		}
+	}
+
+	if (GLYPH_ATLAS.page_count < SDLCLAY_GLYPH_ATLAS_MAX_PAGES) {
+		SDL_Texture* texture = SDL_CreateTexture(
+			renderer,
+			SDL_PIXELFORMAT_ARGB8888,
+			SDL_TEXTUREACCESS_STATIC,
+			SDLCLAY_GLYPH_ATLAS_PAGE_SIZE,
+			SDLCLAY_GLYPH_ATLAS_PAGE_SIZE
+		);
+		if (texture == NULL) {
+			SDLCLAY_LOG("Failed to create glyph atlas page: %s", SDL_GetError());
+			return -1;
+		}
+		SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+		SDL_SetTextureScaleMode(texture, GLYPH_ATLAS.scale_mode);
+
+		AtlasPage* page = &GLYPH_ATLAS.pages[GLYPH_ATLAS.page_count];
+		SDL_memset(page, 0, sizeof(AtlasPage));
+		page->texture = texture;
+		page->size = SDLCLAY_GLYPH_ATLAS_PAGE_SIZE;
+		GLYPH_ATLAS.page_count++;
+
+		return AtlasPage_pack(page, w, h, out_rect) ? GLYPH_ATLAS.page_count - 1 : -1;
+	}
+
+	// Every page is full: draw what is pending and start over
+	SDLCLAY_LOG("Glyph atlas full, recycling %d pages", GLYPH_ATLAS.page_count);
+	GeometryBatch_flush(renderer);
+	GlyphAtlas_clearGlyphs();
+	for (int i = 0; i < GLYPH_ATLAS.page_count; i++) {
+		AtlasPage* page = &GLYPH_ATLAS.pages[i];
+		page->shelf_x = 0;
+		page->shelf_y = 0;
+		page->shelf_height = 0;
+	}
+
+	return AtlasPage_pack(&GLYPH_ATLAS.pages[0], w, h, out_rect) ? 0 : -1;
+}
+
+/**
+ * Render a glyph in white, in the format of the atlas pages, surrounded by a transparent
+ * SDLCLAY_GLYPH_BORDER pixels border. Linear filtering of scaled glyphs samples the border
+ * instead of whatever the page held there.
+ */
+static SDL_Surface* SDLCLAY_RenderGlyph(TTF_Font* font, const uint32_t codepoint) {
+	SDL_Surface* surface = TTF_RenderGlyph_Blended(font, codepoint, (SDL_Color){255, 255, 255, 255});
+	if (surface == NULL) {
+		return NULL;
+	}
+
+	// New surfaces are cleared to transparent
+	SDL_Surface* bordered = SDL_CreateSurface(
+		surface->w + 2 * SDLCLAY_GLYPH_BORDER,
+		surface->h + 2 * SDLCLAY_GLYPH_BORDER,
+		SDL_PIXELFORMAT_ARGB8888
+	);
+	if (bordered != NULL) {
+		SDL_Rect dst = {SDLCLAY_GLYPH_BORDER, SDLCLAY_GLYPH_BORDER, surface->w, surface->h};
+		SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+		if (!SDL_BlitSurface(surface, NULL, bordered, &dst)) {
+			SDL_DestroySurface(bordered);
+			bordered = NULL;
+		}
+	}
+	SDL_DestroySurface(surface);
+	return bordered;
+}
+
+/**
+ * Insert the glyph, or replace the entry it was pending in
+ */
+static Glyph* GlyphAtlas_store(const Glyph glyph) {
+	Glyph* entry = GlyphAtlas_find(glyph.font_id, glyph.font_size, glyph.codepoint);
+	if (entry == NULL) {
+		return GlyphAtlas_insert(glyph);
+	}
+
+	*entry = glyph;
+	entry->used = true;
+	return entry;
+}
+
+/**
+ * Pack the pixels of a glyph, NULL for glyphs without any ink, and store it
+ */
+static Glyph* GlyphAtlas_upload(SDL_Renderer* renderer, Glyph glyph, SDL_Surface* surface) {
+	glyph.pending = false;
+	glyph.page = -1;
+
+	// Allocating can recycle the atlas, the glyph is stored afterwards
+	if (surface != NULL) {
+		glyph.page = GlyphAtlas_allocate(renderer, surface->w, surface->h, &glyph.src);
+		if (glyph.page >= 0) {
+			SDL_UpdateTexture(GLYPH_ATLAS.pages[glyph.page].texture, &glyph.src, surface->pixels, surface->pitch);
+			// Only the glyph is drawn, its border is kept around it in the page
+			glyph.src.x += SDLCLAY_GLYPH_BORDER;
+			glyph.src.y += SDLCLAY_GLYPH_BORDER;
+			glyph.src.w -= 2 * SDLCLAY_GLYPH_BORDER;
+			glyph.src.h -= 2 * SDLCLAY_GLYPH_BORDER;
+		}
+	}
+
+	return GlyphAtlas_store(glyph);
+}
+
+static void GlyphAtlas_bind(SDL_Renderer* renderer) {
+	// Atlas pages belong to a renderer, start over if it changed
+	if (GLYPH_ATLAS.renderer != renderer) {
+		GlyphAtlas_free();
+		GLYPH_ATLAS.renderer = renderer;
+	}
+}
+
+// ===================================================================================
+// MARK: GLYPH WORKERS
+// ===================================================================================
+
+/**
+ * Glyph rasterized by a worker, with the font bytes it opens its own instance from
+ */
+typedef struct GlyphJob {
+	uint16_t font_id;
+	uint16_t font_size;
+	uint32_t codepoint;
+	const void* font_data;
+	size_t font_data_size;
+	// Result, NULL if it failed
+	SDL_Surface* surface;
+} GlyphJob;
+
+typedef struct GlyphWorker {
+	SDL_Thread* thread;
+	// Fonts opened by this worker only, replaced round robin
+	struct {
+		uint16_t font_id;
+		uint16_t font_size;
+		TTF_Font* font;
+	} fonts[SDLCLAY_GLYPH_WORKER_FONTS];
+	int next_font;
+} GlyphWorker;
+
+static struct GlyphWorkers {
+	GlyphWorker workers[SDLCLAY_GLYPH_WORKERS_MAX];
+	int count;
+	SDLCLAY_GlyphPolicy policy;
+	// Guards the queue, the done list and quit
+	SDL_Mutex* lock;
+	// Signaled when a job is queued or the workers must quit
+	SDL_Condition* work;
+	// Signaled when a job is done
+	SDL_Condition* finished;
+	GlyphJob* queue;
+	int queue_head;
+	int queue_count;
+	GlyphJob* done;
+	int done_count;
+	bool quit;
+	// Jobs queued and not uploaded yet, main thread only. Bounded by
+	// SDLCLAY_GLYPH_QUEUE_CAPACITY so neither the queue nor the done list overflow.
+	int in_flight;
+	// A placeholder was drawn since the last upload
+	bool stale;
+	// Incremented when glyphs drawn as placeholders are uploaded, part of the style
+	// fingerprint so cached frames, layers and scroll contents are drawn again
+	uint32_t generation;
+} GLYPH_WORKERS = {0};
+
+static TTF_Font* GlyphWorker_font(GlyphWorker* worker, const GlyphJob* job) {
+	for (int i = 0; i < SDLCLAY_GLYPH_WORKER_FONTS; i++) {
+		if (worker->fonts[i].font != NULL && worker->fonts[i].font_id == job->font_id && worker->fonts[i].font_size == job->font_size) {
+			return worker->fonts[i].font;
+		}
+	}
+
+	const int slot = worker->next_font;
+	worker->next_font = (worker->next_font + 1) % SDLCLAY_GLYPH_WORKER_FONTS;
+	if (worker->fonts[slot].font != NULL) {
+		Fonts_lock();
+		TTF_CloseFont(worker->fonts[slot].font);
+		Fonts_unlock();
+	}
+
+	worker->fonts[slot].font_id = job->font_id;
+	worker->fonts[slot].font_size = job->font_size;
+	worker->fonts[slot].font = SDLCLAY_OpenFontMemory(job->font_data, job->font_data_size, (float) job->font_size);
+	return worker->fonts[slot].font;
+}
+
+static int SDLCALL GlyphWorker_run(void* data) {
+	GlyphWorker* worker = data;
+
+	SDL_LockMutex(GLYPH_WORKERS.lock);
+	while (true) {
+		while (!GLYPH_WORKERS.quit && GLYPH_WORKERS.queue_count == 0) {
+			SDL_WaitCondition(GLYPH_WORKERS.work, GLYPH_WORKERS.lock);
+		}
+		if (GLYPH_WORKERS.quit) {
+			break;
+		}
+
+		GlyphJob job = GLYPH_WORKERS.queue[GLYPH_WORKERS.queue_head];
+		GLYPH_WORKERS.queue_head = (GLYPH_WORKERS.queue_head + 1) % SDLCLAY_GLYPH_QUEUE_CAPACITY;
+		GLYPH_WORKERS.queue_count--;
+		SDL_UnlockMutex(GLYPH_WORKERS.lock);
+
+		TTF_Font* font = GlyphWorker_font(worker, &job);
+		job.surface = font != NULL ? SDLCLAY_RenderGlyph(font, job.codepoint) : NULL;
+
+		SDL_LockMutex(GLYPH_WORKERS.lock);
+		GLYPH_WORKERS.done[GLYPH_WORKERS.done_count++] = job;
+		SDL_BroadcastCondition(GLYPH_WORKERS.finished);
+	}
+	SDL_UnlockMutex(GLYPH_WORKERS.lock);
+
+	Fonts_lock();
+	for (int i = 0; i < SDLCLAY_GLYPH_WORKER_FONTS; i++) {
+		if (worker->fonts[i].font != NULL) {
+			TTF_CloseFont(worker->fonts[i].font);
+		}
+	}
+	Fonts_unlock();
+	return 0;
+}
+
+static void GlyphWorkers_stop() {
+	if (GLYPH_WORKERS.lock != NULL) {
+		SDL_LockMutex(GLYPH_WORKERS.lock);
+		GLYPH_WORKERS.quit = true;
+		SDL_BroadcastCondition(GLYPH_WORKERS.work);
+		SDL_UnlockMutex(GLYPH_WORKERS.lock);
+	}
+
+	for (int i = 0; i < GLYPH_WORKERS.count; i++) {
+		SDL_WaitThread(GLYPH_WORKERS.workers[i].thread, NULL);
+	}
+
+	for (int i = 0; i < GLYPH_WORKERS.done_count; i++) {
+		SDL_DestroySurface(GLYPH_WORKERS.done[i].surface);
+	}
+	if (GLYPH_WORKERS.queue != NULL) {
+		SDLCLAY_FREE(GLYPH_WORKERS.queue);
+	}
+	if (GLYPH_WORKERS.done != NULL) {
+		SDLCLAY_FREE(GLYPH_WORKERS.done);
+	}
+	SDL_DestroyCondition(GLYPH_WORKERS.work);
+	SDL_DestroyCondition(GLYPH_WORKERS.finished);
+	SDL_DestroyMutex(GLYPH_WORKERS.lock);
+	Fonts_setThreaded(false);
+
+	// Glyphs still pending are rasterized on the main thread when next drawn
+	const uint32_t generation = GLYPH_WORKERS.generation + (GLYPH_WORKERS.count > 0 ? 1 : 0);
+	SDL_memset(&GLYPH_WORKERS, 0, sizeof(GLYPH_WORKERS));
+	GLYPH_WORKERS.generation = generation;
+}
+
+/**
+ * Queue a glyph for the workers
+ * @return false if it must be rasterized on the main thread
+ */
+static bool GlyphWorkers_enqueue(const uint16_t font_id, const uint16_t font_size, const uint32_t codepoint) {
+	// Fonts added with SDLCLAY_AddFontRaw cannot be opened again by the workers
+	if (GLYPH_WORKERS.count == 0 || GLYPH_WORKERS.in_flight >= SDLCLAY_GLYPH_QUEUE_CAPACITY || FONTS.fonts[font_id].data == NULL) {
+		return false;
+	}
+
+	const GlyphJob job = {
+		.font_id = font_id,
+		.font_size = font_size,
+		.codepoint = codepoint,
+		.font_data = FONTS.fonts[font_id].data,
+		.font_data_size = FONTS.fonts[font_id].data_size,
+	};
+
+	SDL_LockMutex(GLYPH_WORKERS.lock);
+	GLYPH_WORKERS.queue[(GLYPH_WORKERS.queue_head + GLYPH_WORKERS.queue_count) % SDLCLAY_GLYPH_QUEUE_CAPACITY] = job;
+	GLYPH_WORKERS.queue_count++;
+	SDL_SignalCondition(GLYPH_WORKERS.work);
+	SDL_UnlockMutex(GLYPH_WORKERS.lock);
+
+	GLYPH_WORKERS.in_flight++;
+	STATS.glyph_jobs++;
+	return true;
+}
+
+/**
+ * Upload the glyphs finished by the workers
+ * @param wait Wait until every queued glyph is finished
+ */
+static void GlyphWorkers_collect(SDL_Renderer* renderer, const bool wait) {
+	SDL_LockMutex(GLYPH_WORKERS.lock);
+	while (wait && GLYPH_WORKERS.done_count < GLYPH_WORKERS.in_flight) {
+		SDL_WaitCondition(GLYPH_WORKERS.finished, GLYPH_WORKERS.lock);
+	}
+
+	const int uploads = GLYPH_WORKERS.done_count;
+	for (int i = 0; i < GLYPH_WORKERS.done_count; i++) {
+		GlyphJob* job = &GLYPH_WORKERS.done[i];
+		// Dropped if the atlas was recycled meanwhile, it is queued again when drawn
+		const Glyph* glyph = GlyphAtlas_find(job->font_id, job->font_size, job->codepoint);
+		if (glyph != NULL && glyph->pending) {
+			GlyphAtlas_upload(renderer, *glyph, job->surface);
+		}
+		SDL_DestroySurface(job->surface);
+	}
+	GLYPH_WORKERS.done_count = 0;
+	SDL_UnlockMutex(GLYPH_WORKERS.lock);
+
+	GLYPH_WORKERS.in_flight -= uploads;
+	STATS.glyph_uploads += uploads;
+	STATS.text_rasterizations += uploads;
+	if (uploads > 0 && GLYPH_WORKERS.stale) {
+		GLYPH_WORKERS.stale = false;
+		GLYPH_WORKERS.generation++;
+	}
+}
+
+/**
+ * Whether placeholders were drawn and glyphs replacing them are ready to upload
+ */
+static bool GlyphWorkers_hasUpdates() {
+	if (GLYPH_WORKERS.count == 0 || !GLYPH_WORKERS.stale) {
+		return false;
+	}
+
+	SDL_LockMutex(GLYPH_WORKERS.lock);
+	const bool has_updates = GLYPH_WORKERS.done_count > 0;
+	SDL_UnlockMutex(GLYPH_WORKERS.lock);
+	return has_updates;
+}
+
+static Glyph* GlyphAtlas_rasterize(
+	SDL_Renderer* renderer,
+	const uint16_t font_id,
+	const uint16_t font_size,
+	const uint32_t codepoint
+) {
+	TTF_Font* font = SDLCLAY_GetFont(font_id, font_size);
+	if (font == NULL) {
+		return NULL;
+	}
+
+	Glyph glyph = {
+		.codepoint = codepoint,
+		.font_id = font_id,
+		.font_size = font_size,
+		.page = -1,
+	};
+
+	int min_x = 0, max_x = 0;
+	TTF_GetGlyphMetrics(font, codepoint, &min_x, &max_x, NULL, NULL, &glyph.advance);
+
+	// TTF_RenderGlyph_Blended lays the glyph out like a one character string,
+	// which is shifted right when the glyph has a negative left bearing
+	glyph.offset_x = SDL_min(min_x, 0);
+
+	const bool has_ink = max_x > min_x;
+	if (has_ink && GlyphWorkers_enqueue(font_id, font_size, codepoint)) {
+		glyph.pending = true;
+		return GlyphAtlas_store(glyph);
+	}
+
+	STATS.text_rasterizations++;
+	SDL_Surface* surface = has_ink ? SDLCLAY_RenderGlyph(font, codepoint) : NULL;
+	Glyph* stored = GlyphAtlas_upload(renderer, glyph, surface);
+	SDL_DestroySurface(surface);
+	return stored;
+}
+
+static const Glyph* GlyphAtlas_get(
+	SDL_Renderer* renderer,
+	const uint16_t font_id,
+	const uint16_t font_size,
+	const uint32_t codepoint
+) {
+	GlyphAtlas_bind(renderer);
+
+	const Glyph* glyph = GlyphAtlas_find(font_id, font_size, codepoint);
+	// Pending glyphs left over by stopped workers are rasterized here
+	if (glyph != NULL && (!glyph->pending || GLYPH_WORKERS.count > 0)) {
+		return glyph;
+	}
+
+	return GlyphAtlas_rasterize(renderer, font_id, font_size, codepoint);
+}
+
+/**
+ * Get every glyph of the text commands, so the missing ones are all queued at once
+ */
+static void GlyphWorkers_prefetch(SDL_Renderer* renderer, Clay_RenderCommandArray* commands_array) {
+	if (TEXT_MODE == SDLCLAY_TEXT_MODE_STRING_CACHE) {
+		return;
+	}
+
+	for (int i = 0; i < commands_array->length; i++) {
+		const Clay_RenderCommand* cmd = Clay_RenderCommandArray_Get(commands_array, i);
+		if (cmd->commandType != CLAY_RENDER_COMMAND_TYPE_TEXT) {
+			continue;
+		}
+
+		const Clay_TextRenderData* config = &cmd->renderData.text;
+		const uint16_t raster_size = SDLCLAY_RasterSize(config->fontSize);
+		const char* chars = config->stringContents.chars;
+		size_t length = (size_t) config->stringContents.length;
+		while (length > 0) {
+			GlyphAtlas_get(renderer, config->fontId, raster_size, SDL_StepUTF8(&chars, &length));
+		}
+	}
+}
+
+/**
+ * Set the filtering of every page. It only changes with the text mode, between frames,
+ * so text commands of any size keep batching together.
+ */
+static void GlyphAtlas_setScaleMode(const SDL_ScaleMode scale_mode) {
+	if (GLYPH_ATLAS.scale_mode == scale_mode) {
+		return;
+	}
+
+	for (int i = 0; i < GLYPH_ATLAS.page_count; i++) {
+		SDL_SetTextureScaleMode(GLYPH_ATLAS.pages[i].texture, scale_mode);
+	}
+	GLYPH_ATLAS.scale_mode = scale_mode;
+}
+
+/**
+ * Draw text from glyphs rasterized at raster_size, scaled to the font size
+ */
+static void GlyphAtlas_renderText(
+	SDL_Renderer* renderer,
+	const Clay_TextRenderData* config,
+	const SDL_FRect rect,
+	const uint16_t raster_size
+) {
+	const SDL_FColor color = {
+		config->textColor.r / 255, config->textColor.g / 255,
+		config->textColor.b / 255, config->textColor.a / 255
+	};
+	TTF_Font* font = SDLCLAY_GetFont(config->fontId, raster_size);
+	if (font == NULL) {
+		return;
+	}
+
+	FontMetrics* metrics = FontMetrics_get(config->fontId, raster_size, font);
+	const float scale = (float) config->fontSize / (float) raster_size;
+	const bool scaled = raster_size != config->fontSize;
+
+	// Glyph cells are integer sized, snap the origin so they map 1:1 to pixels.
+	// Scaled glyphs are filtered anyway and keep their exact position.
+	float pen_x = scaled ? rect.x : SDL_floorf(rect.x + 0.5f);
+	const float pen_y = scaled ? rect.y : SDL_floorf(rect.y + 0.5f);
+
+	const char* chars = config->stringContents.chars;
+	size_t length = (size_t) config->stringContents.length;
+	uint32_t previous = 0;
+
+	while (length > 0) {
+		const uint32_t codepoint = SDL_StepUTF8(&chars, &length);
+
+		if (previous != 0) {
+			// ASCII pairs are kerned from the table measurement fills
+			const bool ascii = previous >= SDLCLAY_ASCII_FIRST && previous <= SDLCLAY_ASCII_LAST
+				&& codepoint >= SDLCLAY_ASCII_FIRST && codepoint <= SDLCLAY_ASCII_LAST;
+			int kerning = 0;
+			if (ascii) {
+				kerning = FontMetrics_kerning(metrics, font, (int) previous, (int) codepoint);
+			} else {
+				TTF_GetGlyphKerning(font, previous, codepoint, &kerning);
+			}
+			pen_x += (float) kerning * scale;
+		}
+		previous = codepoint;
+
+		const Glyph* glyph = GlyphAtlas_get(renderer, config->fontId, raster_size, codepoint);
+		if (glyph == NULL) {
+			continue;
+		}
+
+		// Space left empty, the frame is drawn again once the glyph is uploaded
+		if (glyph->pending) {
+			STATS.glyph_placeholders++;
+			GLYPH_WORKERS.stale = true;
+		}
+
+		if (!glyph->pending && glyph->page >= 0) {
+			const float inv_size = 1.0f / (float) SDLCLAY_GLYPH_ATLAS_PAGE_SIZE;
+			const SDL_FRect dst = {
+				pen_x + (float) glyph->offset_x * scale,
+				pen_y,
+				(float) glyph->src.w * scale,
+				(float) glyph->src.h * scale
+			};
+			const SDL_FRect uv = {
+				(float) glyph->src.x * inv_size,
+				(float) glyph->src.y * inv_size,
+				(float) glyph->src.w * inv_size,
+				(float) glyph->src.h * inv_size
+			};
+
+			if (GeometryBatch_reserve(renderer, GLYPH_ATLAS.pages[glyph->page].texture, 4, 6) >= 0) {
+				GeometryBatch_pushQuad(dst, uv, color);
+			}
+		}
+
+		pen_x += (float) glyph->advance * scale;
+	}
+}
+
+// ===================================================================================
+// MARK: UPLOAD RING
+// ===================================================================================
+
+/**
+ * Area of an upload ring page, valid while the page was not recycled
+ */
+typedef struct UploadSlot {
+	int page;
+	uint32_t generation;
+	SDL_Rect src;
+} UploadSlot;
+
+/**
+ * Persistent streaming textures shared by dynamic uploads, written in place through
+ * SDL_LockTexture. Once every page is full the oldest one is recycled.
+ */
+static struct UploadRing {
+	SDL_Renderer* renderer;
+	AtlasPage pages[SDLCLAY_UPLOAD_RING_PAGES];
+	uint32_t generations[SDLCLAY_UPLOAD_RING_PAGES];
+	int page_count;
+	int next_recycle;
+	// Source of the generations, never reset so slots of freed pages stay invalid
+	uint32_t serial;
+} UPLOAD_RING = {0};
+
+static void UploadRing_free() {
+	for (int i = 0; i < UPLOAD_RING.page_count; i++) {
+		SDL_DestroyTexture(UPLOAD_RING.pages[i].texture);
+	}
+	const uint32_t serial = UPLOAD_RING.serial;
+	SDL_memset(&UPLOAD_RING, 0, sizeof(UPLOAD_RING));
+	UPLOAD_RING.serial = serial;
+}
+
+static void UploadRing_bind(SDL_Renderer* renderer) {
+	// Pages belong to a renderer, start over if it changed
+	if (UPLOAD_RING.renderer != renderer) {
+		UploadRing_free();
+		UPLOAD_RING.renderer = renderer;
+	}
+}
+
+static bool UploadRing_isValid(const UploadSlot* slot) {
+	return slot->page >= 0 && slot->page < UPLOAD_RING.page_count && UPLOAD_RING.generations[slot->page] == slot->generation;
+}
+
+static SDL_Texture* UploadRing_texture(const UploadSlot* slot) {
+	return UPLOAD_RING.pages[slot->page].texture;
+}
+
+/**
+ * Find room for a w*h area, opening a page or recycling the oldest one
+ */
+static bool UploadRing_allocate(SDL_Renderer* renderer, const int w, const int h, UploadSlot* out_slot) {
+	for (int i = 0; i < UPLOAD_RING.page_count; i++) {
+		if (AtlasPage_pack(&UPLOAD_RING.pages[i], w, h, &out_slot->src)) {
+			out_slot->page = i;
+			out_slot->generation = UPLOAD_RING.generations[i];
+			return true;
+		}
+	}
+
+	int page_index = UPLOAD_RING.page_count;
+	if (page_index < SDLCLAY_UPLOAD_RING_PAGES) {
+		SDL_Texture* texture = SDL_CreateTexture(
+			renderer,
+			SDL_PIXELFORMAT_ARGB8888,
+			SDL_TEXTUREACCESS_STREAMING,
+			SDLCLAY_UPLOAD_RING_PAGE_SIZE,
+			SDLCLAY_UPLOAD_RING_PAGE_SIZE
+		);
+		if (texture == NULL) {
+			SDLCLAY_LOG("Failed to create upload ring page: %s", SDL_GetError());
+			return false;
+		}
+		SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+		SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_NEAREST);
+
+		SDL_memset(&UPLOAD_RING.pages[page_index], 0, sizeof(AtlasPage));
+		UPLOAD_RING.pages[page_index].texture = texture;
+		UPLOAD_RING.pages[page_index].size = SDLCLAY_UPLOAD_RING_PAGE_SIZE;
+		UPLOAD_RING.page_count++;
+	} else {
+		// Every page is full: draw what is pending and overwrite the oldest
+		page_index = UPLOAD_RING.next_recycle;
+		UPLOAD_RING.next_recycle = (UPLOAD_RING.next_recycle + 1) % SDLCLAY_UPLOAD_RING_PAGES;
+		GeometryBatch_flush(renderer);
+
+		AtlasPage* page = &UPLOAD_RING.pages[page_index];
+		page->shelf_x = 0;
+		page->shelf_y = 0;
+		page->shelf_height = 0;
+		STATS.upload_ring_recycles++;
+	}
+
+	UPLOAD_RING.generations[page_index] = ++UPLOAD_RING.serial;
+	if (!AtlasPage_pack(&UPLOAD_RING.pages[page_index], w, h, &out_slot->src)) {
+		return false;
+	}
+	out_slot->page = page_index;
+	out_slot->generation = UPLOAD_RING.generations[page_index];
+	return true;
+}
+
+/**
+ * Copy an ARGB8888 surface into a slot of the ring
+ * @return false if it does not fit in a page or cannot be locked
+ */
+static bool UploadRing_upload(SDL_Renderer* renderer, const SDL_Surface* surface, UploadSlot* out_slot) {
+	if (surface->format != SDL_PIXELFORMAT_ARGB8888 || !UploadRing_allocate(renderer, surface->w, surface->h, out_slot)) {
+		return false;
+	}
+
+	void* pixels = NULL;
+	int pitch = 0;
+	if (!SDL_LockTexture(UploadRing_texture(out_slot), &out_slot->src, &pixels, &pitch)) {
+		SDLCLAY_LOG("Failed to lock upload ring page: %s", SDL_GetError());
+		return false;
+	}
+
+	const size_t row_bytes = (size_t) surface->w * 4;
+	for (int y = 0; y < surface->h; y++) {
+		SDL_memcpy(
+			(uint8_t*) pixels + (size_t) y * (size_t) pitch,
+			(const uint8_t*) surface->pixels + (size_t) y * (size_t) surface->pitch,
+			row_bytes
+		);
+	}
+	SDL_UnlockTexture(UploadRing_texture(out_slot));
+
+	STATS.upload_ring_uploads++;
+	return true;
+}
+
+// ===================================================================================
+// MARK: IMAGES
+// ===================================================================================
+
+typedef struct ImageVariant {
+	// Atlas page holding the variant, or a texture of its own
+	SDL_Texture* texture;
+	// Index of the atlas page, -1 for variants with their own texture
+	int page;
+	SDL_Rect src;
+} ImageVariant;
+
+struct SDLCLAY_Image {
+	SDL_Renderer* renderer;
+	// Variants doubling in size from the one created with the image, the last one at
+	// the full size of the source, built the first time they are drawn
+	ImageVariant variants[SDLCLAY_IMAGE_MAX_VARIANTS];
+	SDL_Point sizes[SDLCLAY_IMAGE_MAX_VARIANTS];
+	int variant_count;
+	// ARGB8888 copy of the source, only kept while some variants are yet to be built
+	SDL_Surface* source;
+	// Every pixel is opaque, the image hides what is under it
+	bool opaque;
+};
+
+static struct ImageAtlas {
+	SDL_Renderer* renderer;
+	AtlasPage pages[SDLCLAY_IMAGE_ATLAS_MAX_PAGES];
+	// Live images of each page, a page left empty is packed again from scratch
+	int image_counts[SDLCLAY_IMAGE_ATLAS_MAX_PAGES];
+	// Areas of destroyed images in each page, reused before packing new shelves
+	SDL_Rect free_rects[SDLCLAY_IMAGE_ATLAS_MAX_PAGES][SDLCLAY_IMAGE_ATLAS_FREE_RECTS];
+	int free_counts[SDLCLAY_IMAGE_ATLAS_MAX_PAGES];
+	int page_count;
+	// Images in a texture of their own, too large or left out of full pages
+	int standalone_count;
+	// Set of the live handles, telling them apart from SDL_Texture image data
+	SDLCLAY_Image** handles;
+	int handle_count;
+	int handle_capacity;
+} IMAGE_ATLAS = {0};
+
+static uint32_t ImageSet_index(const void* pointer) {
+	const uint32_t mask = (uint32_t) IMAGE_ATLAS.handle_capacity - 1;
+	return ((uint32_t) ((uintptr_t) pointer >> 4) * 0x9E3779B1u) & mask;
+}
+
+static SDLCLAY_Image* ImageSet_find(const void* pointer) {
+	if (IMAGE_ATLAS.handle_count == 0 || pointer == NULL) {
+		return NULL;
+	}
+
+	const uint32_t mask = (uint32_t) IMAGE_ATLAS.handle_capacity - 1;
+	for (uint32_t index = ImageSet_index(pointer); IMAGE_ATLAS.handles[index] != NULL; index = (index + 1) & mask) {
+		if (IMAGE_ATLAS.handles[index] == pointer) {
+			return IMAGE_ATLAS.handles[index];
+		}
+	}
+	return NULL;
+}
+
+static bool ImageSet_insert(SDLCLAY_Image* image) {
+	// Keep the load factor under 1/2
+	if ((IMAGE_ATLAS.handle_count + 1) * 2 > IMAGE_ATLAS.handle_capacity) {
+		SDLCLAY_Image** old_handles = IMAGE_ATLAS.handles;
+		const int old_capacity = IMAGE_ATLAS.handle_capacity;
+		const int new_capacity = old_capacity > 0 ? old_capacity * 2 : 64;
+
+		SDLCLAY_Image** new_handles = SDLCLAY_MALLOC((size_t) new_capacity * sizeof(SDLCLAY_Image*));
+		if (new_handles == NULL) {
+			return false;
+		}
+		SDL_memset(new_handles, 0, (size_t) new_capacity * sizeof(SDLCLAY_Image*));
+
+		IMAGE_ATLAS.handles = new_handles;
+		IMAGE_ATLAS.handle_capacity = new_capacity;
+		IMAGE_ATLAS.handle_count = 0;
+		for (int i = 0; i < old_capacity; i++) {
+			if (old_handles[i] != NULL) {
+				ImageSet_insert(old_handles[i]);
+			}
+		}
+		if (old_handles != NULL) {
+			SDLCLAY_FREE(old_handles);
+		}
+	}
+
+	const uint32_t mask = (uint32_t) IMAGE_ATLAS.handle_capacity - 1;
+	uint32_t index = ImageSet_index(image);
+	while (IMAGE_ATLAS.handles[index] != NULL) {
+		index = (index + 1) & mask;
+	}
+	IMAGE_ATLAS.handles[index] = image;
+	IMAGE_ATLAS.handle_count++;
+	return true;
+}
+
+static void ImageSet_remove(const SDLCLAY_Image* image) {
+	if (IMAGE_ATLAS.handle_count == 0) {
+		return;
+	}
+
+	const uint32_t mask = (uint32_t) IMAGE_ATLAS.handle_capacity - 1;
+	uint32_t index = ImageSet_index(image);
+	while (IMAGE_ATLAS.handles[index] != image) {
+		if (IMAGE_ATLAS.handles[index] == NULL) {
+			return;
+		}
+		index = (index + 1) & mask;
+	}
+
+	// Shift back the following handles of the cluster so lookups never stop early
+	uint32_t hole = index;
+	for (uint32_t next = (index + 1) & mask; IMAGE_ATLAS.handles[next] != NULL; next = (next + 1) & mask) {
+		const uint32_t home = ImageSet_index(IMAGE_ATLAS.handles[next]);
+		if (((next - home) & mask) >= ((next - hole) & mask)) {
+			IMAGE_ATLAS.handles[hole] = IMAGE_ATLAS.handles[next];
+			hole = next;
+		}
+	}
+	IMAGE_ATLAS.handles[hole] = NULL;
+	IMAGE_ATLAS.handle_count--;
+}
+
+static bool SDLCLAY_IsOpaqueSurface(const SDL_Surface* surface) {
+	for (int y = 0; y < surface->h; y++) {
+		const uint32_t* row = (const uint32_t*) ((const uint8_t*) surface->pixels + (size_t) y * (size_t) surface->pitch);
+		for (int x = 0; x < surface->w; x++) {
+			if (row[x] >> 24 != 0xFF) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Halve an ARGB8888 surface row by row, each output pixel averaging a 2x2 box
+static void SDLCLAY_HalveRow(const uint32_t* row0, const uint32_t* row1, uint32_t* out, const int out_w) {
+	int x = 0;
+#ifdef SDL_SSE2_INTRINSICS
+	// Two output pixels from four pixels of each row, channels widened to 16 bits
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i round = _mm_set1_epi16(2);
+	for (; x + 2 <= out_w; x += 2) {
+		const __m128i top = _mm_loadu_si128((const __m128i*) (row0 + 2 * x));
+		const __m128i bottom = _mm_loadu_si128((const __m128i*) (row1 + 2 * x));
+		const __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+		const __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+		__m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(low, high), _mm_unpackhi_epi64(low, high));
+		sum = _mm_srli_epi16(_mm_add_epi16(sum, round), 2);
+		_mm_storel_epi64((__m128i*) (out + x), _mm_packus_epi16(sum, sum));
+	}
+#endif
+	for (; x < out_w; x++) {
+		const uint32_t a = row0[2 * x], b = row0[2 * x + 1], c = row1[2 * x], d = row1[2 * x + 1];
+		uint32_t pixel = 0;
+		for (uint32_t shift = 0; shift < 32; shift += 8) {
+			const uint32_t sum = ((a >> shift) & 0xFF) + ((b >> shift) & 0xFF) + ((c >> shift) & 0xFF) + ((d >> shift) & 0xFF) + 2;
+			pixel |= (sum >> 2) << shift;
+		}
+		out[x] = pixel;
+	}
+}
+
+// Bilinear sample between two pixels of two rows, weights out of 128
+static uint32_t SDLCLAY_BilinearPixel(
+	const uint32_t top_left, const uint32_t top_right,
+	const uint32_t bottom_left, const uint32_t bottom_right,
+	const int fx, const int fy
+) {
+#ifdef SDL_SSE2_INTRINSICS
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i round = _mm_set1_epi16(64);
+	const __m128i top = _mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128((int) top_left), _mm_cvtsi32_si128((int) top_right)), zero);
+	const __m128i bottom = _mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128((int) bottom_left), _mm_cvtsi32_si128((int) bottom_right)), zero);
+	__m128i column = _mm_add_epi16(_mm_mullo_epi16(top, _mm_set1_epi16((short) (128 - fy))), _mm_mullo_epi16(bottom, _mm_set1_epi16((short) fy)));
+	column = _mm_srli_epi16(_mm_add_epi16(column, round), 7);
+	const short left = (short) (128 - fx), right = (short) fx;
+	__m128i sum = _mm_mullo_epi16(column, _mm_set_epi16(right, right, right, right, left, left, left, left));
+	sum = _mm_add_epi16(sum, _mm_srli_si128(sum, 8));
+	sum = _mm_srli_epi16(_mm_add_epi16(sum, round), 7);
+	return (uint32_t) _mm_cvtsi128_si32(_mm_packus_epi16(sum, sum));
+#else
+	uint32_t pixel = 0;
+	for (uint32_t shift = 0; shift < 32; shift += 8) {
+		const uint32_t left = (((top_left >> shift) & 0xFF) * (uint32_t) (128 - fy) + ((bottom_left >> shift) & 0xFF) * (uint32_t) fy + 64) >> 7;
+		const uint32_t right = (((top_right >> shift) & 0xFF) * (uint32_t) (128 - fy) + ((bottom_right >> shift) & 0xFF) * (uint32_t) fy + 64) >> 7;
+		pixel |= ((left * (uint32_t) (128 - fx) + right * (uint32_t) fx + 64) >> 7) << shift;
+	}
+	return pixel;
+#endif
+}
+
+// Straight alpha back from premultiplied ARGB8888, rounded to the nearest
+static void SDLCLAY_UnpremultiplySurface(SDL_Surface* surface) {
+	for (int y = 0; y < surface->h; y++) {
+		uint32_t* row = (uint32_t*) ((uint8_t*) surface->pixels + (size_t) y * (size_t) surface->pitch);
+		for (int x = 0; x < surface->w; x++) {
+			const uint32_t alpha = row[x] >> 24;
+			if (alpha == 0 || alpha == 0xFF) {
+				continue;
+			}
+			uint32_t pixel = alpha << 24;
+			for (uint32_t shift = 0; shift < 24; shift += 8) {
+				const uint32_t channel = (((row[x] >> shift) & 0xFF) * 0xFF + alpha / 2) / alpha;
+				pixel |= SDL_min(channel, 0xFFu) << shift;
+			}
+			row[x] = pixel;
+		}
+	}
+}
+
+/**
+ * Downscale an ARGB8888 surface, halving it with a box filter while it is at least twice
+ * the target size, then resampling the rest bilinearly
+ * @param opaque Whether every pixel is opaque, others are filtered with premultiplied alpha
+ * so the color of transparent pixels doesn't darken the edges
+ * @return New ARGB8888 surface, NULL on failure
+ */
+static SDL_Surface* SDLCLAY_ScaleSurface(SDL_Surface* source, const int w, const int h, const bool opaque) {
+	SDL_Surface* current = source;
+	if (!opaque) {
+		current = SDL_DuplicateSurface(source);
+		if (current == NULL || !SDL_PremultiplySurfaceAlpha(current, false)) {
+			SDL_DestroySurface(current);
+			return NULL;
+		}
+	}
+
+	while (current->w >= 2 * w && current->h >= 2 * h) {
+		SDL_Surface* halved = SDL_CreateSurface(current->w / 2, current->h / 2, SDL_PIXELFORMAT_ARGB8888);
+		if (halved == NULL) {
+			break;
+		}
+		for (int y = 0; y < halved->h; y++) {
+			const uint8_t* row = (const uint8_t*) current->pixels + (size_t) (2 * y) * (size_t) current->pitch;
+			SDLCLAY_HalveRow(
+				(const uint32_t*) row,
+				(const uint32_t*) (row + current->pitch),
+				(uint32_t*) ((uint8_t*) halved->pixels + (size_t) y * (size_t) halved->pitch),
+				halved->w
+			);
+		}
+		if (current != source) {
+			SDL_DestroySurface(current);
+		}
+		current = halved;
+	}
+
+	if (current->w == w && current->h == h) {
+		if (current == source) {
+			return SDL_DuplicateSurface(source);
+		}
+		if (!opaque) {
+			SDLCLAY_UnpremultiplySurface(current);
+		}
+		return current;
+	}
+
+	SDL_Surface* scaled = SDL_CreateSurface(w, h, SDL_PIXELFORMAT_ARGB8888);
+	if (scaled != NULL) {
+		// Sample at the pixel centers, in 16.16 fixed point
+		const int step_x = (int) (((int64_t) current->w << 16) / w);
+		const int step_y = (int) (((int64_t) current->h << 16) / h);
+		for (int y = 0; y < h; y++) {
+			const int position_y = SDL_max(y * step_y + step_y / 2 - 0x8000, 0);
+			const int y0 = position_y >> 16, y1 = SDL_min(y0 + 1, current->h - 1);
+			const int fy = (position_y >> 9) & 127;
+			const uint32_t* row0 = (const uint32_t*) ((const uint8_t*) current->pixels + (size_t) y0 * (size_t) current->pitch);
+			const uint32_t* row1 = (const uint32_t*) ((const uint8_t*) current->pixels + (size_t) y1 * (size_t) current->pitch);
+			uint32_t* out = (uint32_t*) ((uint8_t*) scaled->pixels + (size_t) y * (size_t) scaled->pitch);
+			for (int x = 0; x < w; x++) {
+				const int position_x = SDL_max(x * step_x + step_x / 2 - 0x8000, 0);
+				const int x0 = position_x >> 16, x1 = SDL_min(x0 + 1, current->w - 1);
+				out[x] = SDLCLAY_BilinearPixel(row0[x0], row0[x1], row1[x0], row1[x1], (position_x >> 9) & 127, fy);
+			}
+		}
+		if (!opaque) {
+			SDLCLAY_UnpremultiplySurface(scaled);
+		}
+	}
+
+	if (current != source) {
+		SDL_DestroySurface(current);
+	}
+	return scaled;
+}
+
+/**
+ * Give back an area of a page, too small areas and those over the list capacity are lost
+ * until the page is empty
+ */
+static void ImageAtlas_release(const int page_index, const SDL_Rect rect) {
+	// An image takes at least its two border pixels and one of its own
+	if (rect.w < 3 || rect.h < 3 || IMAGE_ATLAS.free_counts[page_index] == SDLCLAY_IMAGE_ATLAS_FREE_RECTS) {
+		return;
+	}
+	IMAGE_ATLAS.free_rects[page_index][IMAGE_ATLAS.free_counts[page_index]++] = rect;
+}
+
+/**
+ * Take a w*h area from the smallest released area it fits in, splitting off the rest
+ */
+static bool ImageAtlas_reuse(const int page_index, const int w, const int h, SDL_Rect* out_rect) {
+	SDL_Rect* rects = IMAGE_ATLAS.free_rects[page_index];
+	int best = -1;
+	for (int i = 0; i < IMAGE_ATLAS.free_counts[page_index]; i++) {
+		if (rects[i].w >= w && rects[i].h >= h && (best < 0 || rects[i].w * rects[i].h < rects[best].w * rects[best].h)) {
+			best = i;
+		}
+	}
+	if (best < 0) {
+		return false;
+	}
+
+	const SDL_Rect rect = rects[best];
+	rects[best] = rects[--IMAGE_ATLAS.free_counts[page_index]];
+
+	// Edges are extruded, areas can touch without bleeding into each other
+	*out_rect = (SDL_Rect){rect.x, rect.y, w, h};
+	ImageAtlas_release(page_index, (SDL_Rect){rect.x + w, rect.y, rect.w - w, h});
+	ImageAtlas_release(page_index, (SDL_Rect){rect.x, rect.y + h, rect.w, rect.h - h});
+	return true;
+}
+
+/**
+ * Pack an ARGB8888 surface in the atlas with its edges repeated one pixel around,
+ * so linear filtering never reads the neighbours
+ */
+static bool ImageAtlas_pack(SDL_Renderer* renderer, const SDL_Surface* surface, ImageVariant* variant) {
+	if (IMAGE_ATLAS.renderer != NULL && IMAGE_ATLAS.renderer != renderer) {
+		return false;
+	}
+
+	const int w = surface->w + 2, h = surface->h + 2;
+	SDL_Rect rect = {0};
+	int page_index = -1;
+	for (int i = 0; i < IMAGE_ATLAS.page_count && page_index < 0; i++) {
+		if (ImageAtlas_reuse(i, w, h, &rect) || AtlasPage_pack(&IMAGE_ATLAS.pages[i], w, h, &rect)) {
+			page_index = i;
+		}
+	}
+
+	if (page_index < 0) {
+		if (IMAGE_ATLAS.page_count == SDLCLAY_IMAGE_ATLAS_MAX_PAGES) {
+			return false;
+		}
+
+		SDL_Texture* texture = SDL_CreateTexture(
+			renderer,
+			SDL_PIXELFORMAT_ARGB8888,
+			SDL_TEXTUREACCESS_STATIC,
+			SDLCLAY_IMAGE_ATLAS_PAGE_SIZE,
+			SDLCLAY_IMAGE_ATLAS_PAGE_SIZE
+		);
+		if (texture == NULL) {
+			SDLCLAY_LOG("Failed to create image atlas page: %s", SDL_GetError());
+			return false;
+		}
+		SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+		SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_LINEAR);
+
+		page_index = IMAGE_ATLAS.page_count++;
+		AtlasPage* page = &IMAGE_ATLAS.pages[page_index];
+		SDL_memset(page, 0, sizeof(AtlasPage));
+		page->texture = texture;
+		page->size = SDLCLAY_IMAGE_ATLAS_PAGE_SIZE;
+		IMAGE_ATLAS.image_counts[page_index] = 0;
+		IMAGE_ATLAS.renderer = renderer;
+
+		if (!AtlasPage_pack(page, w, h, &rect)) {
+			return false;
+		}
+	}
+
+	uint32_t* pixels = SDLCLAY_MALLOC((size_t) w * (size_t) h * sizeof(uint32_t));
+	if (pixels == NULL) {
+		return false;
+	}
+	for (int y = 0; y < h; y++) {
+		const int source_y = SDL_clamp(y - 1, 0, surface->h - 1);
+		const uint32_t* row = (const uint32_t*) ((const uint8_t*) surface->pixels + (size_t) source_y * (size_t) surface->pitch);
+		for (int x = 0; x < w; x++) {
+			pixels[y * w + x] = row[SDL_clamp(x - 1, 0, surface->w - 1)];
+		}
+	}
+	const bool updated = SDL_UpdateTexture(IMAGE_ATLAS.pages[page_index].texture, &rect, pixels, w * (int) sizeof(uint32_t));
+	SDLCLAY_FREE(pixels);
+	if (!updated) {
+		return false;
+	}
+
+	variant->texture = IMAGE_ATLAS.pages[page_index].texture;
+	variant->page = page_index;
+	variant->src = (SDL_Rect){rect.x + 1, rect.y + 1, surface->w, surface->h};
+	IMAGE_ATLAS.image_counts[page_index]++;
+	return true;
+}
+
+static void ImageAtlas_free() {
+	for (int i = 0; i < IMAGE_ATLAS.page_count; i++) {
+		SDL_DestroyTexture(IMAGE_ATLAS.pages[i].texture);
+	}
+	if (IMAGE_ATLAS.handles != NULL) {
+		SDLCLAY_FREE(IMAGE_ATLAS.handles);
+	}
+	SDL_memset(&IMAGE_ATLAS, 0, sizeof(IMAGE_ATLAS));
+}
+
+static bool ImageVariant_create(SDL_Renderer* renderer, SDL_Surface* surface, ImageVariant* variant) {
+	*variant = (ImageVariant){.page = -1, .src = {0, 0, surface->w, surface->h}};
+	const bool small = surface->w <= SDLCLAY_IMAGE_ATLAS_MAX_SIZE && surface->h <= SDLCLAY_IMAGE_ATLAS_MAX_SIZE;
+	if (!small || !ImageAtlas_pack(renderer, surface, variant)) {
+		variant->texture = SDL_CreateTextureFromSurface(renderer, surface);
+		IMAGE_ATLAS.standalone_count += variant->texture != NULL;
+	}
+	return variant->texture != NULL;
+}
+
+static void ImageVariant_destroy(ImageVariant* variant) {
+	if (variant->texture == NULL) {
+		return;
+	}
+
+	if (variant->page >= 0) {
+		if (--IMAGE_ATLAS.image_counts[variant->page] == 0) {
+			AtlasPage* page = &IMAGE_ATLAS.pages[variant->page];
+			page->shelf_x = 0;
+			page->shelf_y = 0;
+			page->shelf_height = 0;
+			IMAGE_ATLAS.free_counts[variant->page] = 0;
+		} else {
+			// The packed area includes the extruded edges
+			const SDL_Rect area = {variant->src.x - 1, variant->src.y - 1, variant->src.w + 2, variant->src.h + 2};
+			ImageAtlas_release(variant->page, area);
+		}
+	} else {
+		SDL_DestroyTexture(variant->texture);
+		IMAGE_ATLAS.standalone_count--;
+	}
+	variant->texture = NULL;
+}
+
+/**
+ * Build a variant from the source, which is released once every variant exists
+ */
+static void Image_buildVariant(SDLCLAY_Image* image, const int index) {
+	const SDL_Point size = image->sizes[index];
+	SDL_Surface* scaled = size.x == image->source->w && size.y == image->source->h
+		? image->source
+		: SDLCLAY_ScaleSurface(image->source, size.x, size.y, image->opaque);
+	if (scaled == NULL) {
+		return;
+	}
+
+	if (ImageVariant_create(image->renderer, scaled, &image->variants[index])) {
+		STATS.image_variants++;
+	}
+	if (scaled != image->source) {
+		SDL_DestroySurface(scaled);
+	}
+
+	for (int i = 0; i < image->variant_count; i++) {
+		if (image->variants[i].texture == NULL) {
+			return;
+		}
+	}
+	SDL_DestroySurface(image->source);
+	image->source = NULL;
+}
+
+/**
+ * Smallest variant covering w*h pixels, built from the source if it is not yet
+ */
+static const ImageVariant* Image_variant(SDLCLAY_Image* image, const float w, const float h) {
+	int index = 0;
+	while (index < image->variant_count - 1) {
+		const SDL_Point size = image->sizes[index];
+		if ((float) size.x + 0.5f >= w && (float) size.y + 0.5f >= h) {
+			break;
+		}
+		index++;
+	}
+
+	if (image->variants[index].texture == NULL && image->source != NULL) {
+		Image_buildVariant(image, index);
+	}
+
+	// Fall back to the closest smaller variant, the first one always exists
+	while (image->variants[index].texture == NULL && index > 0) {
+		index--;
+	}
+	return &image->variants[index];
+}
+
+/**
+ * Texture and normalized source area of Clay image data, an SDLCLAY_Image or an SDL_Texture
+ * @param w, h Size in pixels the image is drawn at, selecting the variant of images
+ */
+static SDL_Texture* SDLCLAY_ResolveImage(void* image_data, const float w, const float h, SDL_FRect* uv) {
+	SDLCLAY_Image* image = ImageSet_find(image_data);
+	if (image == NULL) {
+		*uv = (SDL_FRect){0, 0, 1, 1};
+		return image_data;
+	}
+
+	const ImageVariant* variant = Image_variant(image, w, h);
+	if (variant->page < 0) {
+		*uv = (SDL_FRect){0, 0, 1, 1};
+	} else {
+		const float inv_size = 1.0f / (float) SDLCLAY_IMAGE_ATLAS_PAGE_SIZE;
+		*uv = (SDL_FRect){
+			(float) variant->src.x * inv_size,
+			(float) variant->src.y * inv_size,
+			(float) variant->src.w * inv_size,
+			(float) variant->src.h * inv_size
+		};
+	}
+	return variant->texture;
+}
+
+SDLCLAY_Image* SDLCLAY_CreateImage(SDL_Renderer* renderer, SDL_Surface* surface) {
+	if (surface == NULL) {
+		SDLCLAY_LOG("Invalid surface: %s", SDL_GetError());
+		return NULL;
+	}
+	return SDLCLAY_CreateImageScaled(renderer, surface, surface->w, surface->h, 1);
+}
+
+SDLCLAY_Image* SDLCLAY_CreateImageScaled(
+	SDL_Renderer* renderer,
+	SDL_Surface* surface,
+	const int w,
+	const int h,
+	const int max_variants
+) {
+	if (renderer == NULL || surface == NULL || w <= 0 || h <= 0) {
+		SDLCLAY_LOG("Invalid renderer %p, surface %p or size %dx%d: %s", renderer, surface, w, h, SDL_GetError());
+		return NULL;
+	}
+
+	SDL_Surface* converted = surface->format == SDL_PIXELFORMAT_ARGB8888
+		? surface
+		: SDL_ConvertSurface(surface, SDL_PIXELFORMAT_ARGB8888);
+	SDLCLAY_Image* image = converted != NULL ? SDLCLAY_MALLOC(sizeof(SDLCLAY_Image)) : NULL;
+	if (image == NULL) {
+		SDLCLAY_LOG("Failed to create image: %s", SDL_GetError());
+		if (converted != NULL && converted != surface) {
+			SDL_DestroySurface(converted);
+		}
+		return NULL;
+	}
+
+	// Never scaled up, shrunk uniformly to fit the source so the aspect ratio is kept
+	const SDL_Point full_size = {converted->w, converted->h};
+	const float fit = SDL_min(1.0f, SDL_min((float) full_size.x / (float) w, (float) full_size.y / (float) h));
+	*image = (SDLCLAY_Image){
+		.renderer = renderer,
+		.sizes = {{
+			SDL_clamp((int) SDL_roundf((float) w * fit), 1, full_size.x),
+			SDL_clamp((int) SDL_roundf((float) h * fit), 1, full_size.y)
+		}},
+		.variant_count = 1,
+		.opaque = SDLCLAY_IsOpaqueSurface(converted),
+	};
+
+	// Larger variants double in size and the last one is the source size
+	const int variant_limit = SDL_clamp(max_variants, 1, SDLCLAY_IMAGE_MAX_VARIANTS);
+	while (image->variant_count < variant_limit) {
+		const SDL_Point previous = image->sizes[image->variant_count - 1];
+		if (previous.x == full_size.x && previous.y == full_size.y) {
+			break;
+		}
+		const bool last = image->variant_count == variant_limit - 1
+			|| previous.x * 2 >= full_size.x
+			|| previous.y * 2 >= full_size.y;
+		image->sizes[image->variant_count++] = last ? full_size : (SDL_Point){previous.x * 2, previous.y * 2};
+	}
+
+	bool created = false;
+	if (image->sizes[0].x == full_size.x && image->sizes[0].y == full_size.y) {
+		created = ImageVariant_create(renderer, converted, &image->variants[0]);
+	} else {
+		SDL_Surface* scaled = SDLCLAY_ScaleSurface(converted, image->sizes[0].x, image->sizes[0].y, image->opaque);
+		if (scaled != NULL) {
+			created = ImageVariant_create(renderer, scaled, &image->variants[0]);
+			SDL_DestroySurface(scaled);
+		}
+	}
+
+	// Larger variants are scaled from a copy of the source when first drawn
+	if (image->variant_count > 1) {
+		image->source = converted != surface ? converted : SDL_DuplicateSurface(surface);
+		created = created && image->source != NULL;
+	}
+	if (converted != surface && converted != image->source) {
+		SDL_DestroySurface(converted);
+	}
+
+	if (!created || !ImageSet_insert(image)) {
+		SDLCLAY_LOG("Failed to create image: %s", SDL_GetError());
+		SDLCLAY_DestroyImage(image);
+		return NULL;
+	}
+
+	return image;
+}
+
+void SDLCLAY_DestroyImage(SDLCLAY_Image* image) {
+	if (image == NULL) {
+		return;
+	}
+
+	ImageSet_remove(image);
+	for (int i = 0; i < image->variant_count; i++) {
+		ImageVariant_destroy(&image->variants[i]);
+	}
+	if (image->source != NULL) {
+		SDL_DestroySurface(image->source);
+	}
+	SDLCLAY_FREE(image);
+}
+
+void SDLCLAY_RenderImage(SDL_Renderer* renderer, SDLCLAY_Image* image, const SDL_FRect* dst) {
+	if (image == NULL) {
+		return;
+	}
+
+	// Pick the variant from the size in pixels of the output
+	float w = 0, h = 0;
+	if (dst != NULL) {
+		float scale_x = 1.0f, scale_y = 1.0f;
+		SDL_GetRenderScale(renderer, &scale_x, &scale_y);
+		w = dst->w * scale_x;
+		h = dst->h * scale_y;
+	} else {
+		int output_w = 0, output_h = 0;
+		SDL_GetCurrentRenderOutputSize(renderer, &output_w, &output_h);
+		w = (float) output_w;
+		h = (float) output_h;
+	}
+
+	const ImageVariant* variant = Image_variant(image, w, h);
+	const SDL_FRect src = {(float) variant->src.x, (float) variant->src.y, (float) variant->src.w, (float) variant->src.h};
+	SDL_RenderTexture(renderer, variant->texture, &src, dst);
+}
+
+// ===================================================================================
+// MARK: TEXT CACHE
+// ===================================================================================
+
+#define SDLCLAY_TEXT_CACHE_BUCKETS 1024
+
+typedef struct TextCacheEntry {
+	uint32_t hash;
+	uint16_t font_id;
+	uint16_t font_size;
+	uint32_t color;
+	char* chars;
+	int length;
+	// Area of the upload ring holding the string, or a texture of its own
+	// for strings larger than a ring page
+	UploadSlot slot;
+	SDL_Texture* texture;
+	int w;
+	int h;
+	size_t bytes;
+	uint64_t last_frame;
+	struct TextCacheEntry* bucket_next;
+	// Least recently drawn entries are at the tail
+	struct TextCacheEntry* lru_prev;
+	struct TextCacheEntry* lru_next;
+} TextCacheEntry;
+
+static struct TextCache {
+	TextCacheEntry* buckets[SDLCLAY_TEXT_CACHE_BUCKETS];
+	TextCacheEntry* lru_head;
+	TextCacheEntry* lru_tail;
+	size_t bytes;
+	int count;
+} TEXT_CACHE = {0};
+
+static uint32_t SDLCLAY_HashBytes(const char* bytes, const size_t length) {
+	// FNV-1a
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < length; i++) {
+		hash ^= (uint8_t) bytes[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static uint32_t SDLCLAY_PackColor(const Clay_Color color) {
+	return (uint32_t) color.r << 24 | (uint32_t) color.g << 16 | (uint32_t) color.b << 8 | (uint32_t) color.a;
+}
+
+static void TextCache_unlinkLru(TextCacheEntry* entry) {
+	if (entry->lru_prev != NULL) {
+		entry->lru_prev->lru_next = entry->lru_next;
+	} else {
+		TEXT_CACHE.lru_head = entry->lru_next;
+	}
+
+	if (entry->lru_next != NULL) {
+		entry->lru_next->lru_prev = entry->lru_prev;
+	} else {
+		TEXT_CACHE.lru_tail = entry->lru_prev;
+	}
+
+	entry->lru_prev = NULL;
+	entry->lru_next = NULL;
+}
+
+static void TextCache_pushLru(TextCacheEntry* entry) {
+	entry->lru_next = TEXT_CACHE.lru_head;
+	if (TEXT_CACHE.lru_head != NULL) {
+		TEXT_CACHE.lru_head->lru_prev = entry;
+	}
+	TEXT_CACHE.lru_head = entry;
+	if (TEXT_CACHE.lru_tail == NULL) {
+		TEXT_CACHE.lru_tail = entry;
+	}
+}
+
+static void TextCache_evict(TextCacheEntry* entry) {
+	TextCacheEntry** link = &TEXT_CACHE.buckets[entry->hash % SDLCLAY_TEXT_CACHE_BUCKETS];
+	while (*link != entry) {
+		link = &(*link)->bucket_next;
+	}
+	*link = entry->bucket_next;
+
+	TextCache_unlinkLru(entry);
+
+	TEXT_CACHE.bytes -= entry->bytes;
+	TEXT_CACHE.count--;
+	STATS.text_cache_evictions++;
+
+	if (entry->texture != NULL) {
+		SDL_DestroyTexture(entry->texture);
+	}
+	SDLCLAY_FREE(entry->chars);
+	SDLCLAY_FREE(entry);
+}
+
+/**
+ * Drop entries not drawn for SDLCLAY_TEXT_CACHE_MAX_AGE frames,
+ * then the least recently drawn ones until the cache fits its budget
+ */
+static void TextCache_trim() {
+	while (TEXT_CACHE.lru_tail != NULL) {
+		TextCacheEntry* oldest = TEXT_CACHE.lru_tail;
+		const bool expired = FRAME_INDEX - oldest->last_frame > SDLCLAY_TEXT_CACHE_MAX_AGE;
+		const bool over_budget = TEXT_CACHE.bytes > SDLCLAY_TEXT_CACHE_BUDGET && oldest->last_frame != FRAME_INDEX;
+		if (!expired && !over_budget) {
+			break;
+		}
+		TextCache_evict(oldest);
+	}
+}
+
+static void TextCache_free() {
+	while (TEXT_CACHE.lru_head != NULL) {
+		TextCache_evict(TEXT_CACHE.lru_head);
+	}
+	SDL_memset(&TEXT_CACHE, 0, sizeof(TEXT_CACHE));
+}
+
+/**
+ * Rasterize the string of an entry into the upload ring, or its own texture if too large
+ */
+static bool TextCache_rasterize(SDL_Renderer* renderer, const Clay_TextRenderData* config, TextCacheEntry* entry) {
+	TTF_Font* font = SDLCLAY_GetFont(config->fontId, config->fontSize);
+	if (font == NULL) {
+		return false;
+	}
+	STATS.text_rasterizations++;
+
+	const SDL_Color sdl_color = {
+		(Uint8) config->textColor.r, (Uint8) config->textColor.g,
+		(Uint8) config->textColor.b, (Uint8) config->textColor.a
+	};
+	SDL_Surface* surface = TTF_RenderText_Blended(
+		font,
+		config->stringContents.chars,
+		(size_t) config->stringContents.length,
+		sdl_color
+	);
+	if (surface == NULL) {
+		return false;
+	}
+
+	if (surface->format != SDL_PIXELFORMAT_ARGB8888) {
+		SDL_Surface* converted = SDL_ConvertSurface(surface, SDL_PIXELFORMAT_ARGB8888);
+		SDL_DestroySurface(surface);
+		surface = converted;
+		if (surface == NULL) {
+			return false;
+		}
+	}
+
+	entry->w = surface->w;
+	entry->h = surface->h;
+	entry->texture = NULL;
+	entry->slot = (UploadSlot){.page = -1};
+	if (!UploadRing_upload(renderer, surface, &entry->slot)) {
+		entry->slot.page = -1;
+		entry->texture = SDL_CreateTextureFromSurface(renderer, surface);
+	}
+	SDL_DestroySurface(surface);
+
+	// The ring has its own fixed memory, only textures of their own count in the budget
+	const size_t bytes = entry->texture != NULL ? (size_t) entry->w * (size_t) entry->h * 4 : 0;
+	TEXT_CACHE.bytes = TEXT_CACHE.bytes - entry->bytes + bytes;
+	entry->bytes = bytes;
+
+	return entry->texture != NULL || entry->slot.page >= 0;
+}
+
+static TextCacheEntry* TextCache_get(SDL_Renderer* renderer, const Clay_TextRenderData* config) {
+	UploadRing_bind(renderer);
+
+	const Clay_StringSlice string = config->stringContents;
+	const uint32_t hash = SDLCLAY_HashBytes(string.chars, (size_t) string.length);
+	const uint32_t color = SDLCLAY_PackColor(config->textColor);
+
+	TextCacheEntry* entry = TEXT_CACHE.buckets[hash % SDLCLAY_TEXT_CACHE_BUCKETS];
+	while (entry != NULL) {
+		if (
+			entry->hash == hash && entry->font_id == config->fontId && entry->font_size == config->fontSize &&
+			entry->color == color && entry->length == string.length &&
+			SDL_memcmp(entry->chars, string.chars, (size_t) string.length) == 0
+		) {
+			entry->last_frame = FRAME_INDEX;
+			TextCache_unlinkLru(entry);
+			TextCache_pushLru(entry);
+
+			// The ring page holding it was recycled since
+			if (entry->texture == NULL && !UploadRing_isValid(&entry->slot)) {
+				STATS.text_cache_misses++;
+				return TextCache_rasterize(renderer, config, entry) ? entry : NULL;
+			}
+
+			STATS.text_cache_hits++;
+			return entry;
+		}
+		entry = entry->bucket_next;
+	}
+
+	STATS.text_cache_misses++;
+
+	entry = SDLCLAY_MALLOC(sizeof(TextCacheEntry));
+	char* chars = SDLCLAY_MALLOC((size_t) string.length + 1);
+	if (entry == NULL || chars == NULL) {
+		SDLCLAY_FREE(entry);
+		SDLCLAY_FREE(chars);
+		return NULL;
+	}
+	SDL_memcpy(chars, string.chars, (size_t) string.length);
+	chars[string.length] = '\0';
+
+	*entry = (TextCacheEntry){
+		.hash = hash,
+		.font_id = config->fontId,
+		.font_size = config->fontSize,
+		.color = color,
+		.chars = chars,
+		.length = string.length,
+		.last_frame = FRAME_INDEX,
+	};
+
+	if (!TextCache_rasterize(renderer, config, entry)) {
+		SDLCLAY_FREE(chars);
+		SDLCLAY_FREE(entry);
+		return NULL;
+	}
+
+	TextCacheEntry** bucket = &TEXT_CACHE.buckets[hash % SDLCLAY_TEXT_CACHE_BUCKETS];
+	entry->bucket_next = *bucket;
+	*bucket = entry;
+	TextCache_pushLru(entry);
+
+	TEXT_CACHE.count++;
+
+	return entry;
+}
+
+static void TextCache_renderText(
+	SDL_Renderer* renderer,
+	const Clay_TextRenderData* config,
+	const SDL_FRect rect
+) {
+	if (config->stringContents.length == 0) {
+		return;
+	}
+
+	const TextCacheEntry* entry = TextCache_get(renderer, config);
+	if (entry == NULL) {
+		return;
+	}
+
+	// Color is baked in the texture
+	const SDL_FColor white = {1, 1, 1, 1};
+	const SDL_FRect dst = {
+		SDL_floorf(rect.x + 0.5f),
+		SDL_floorf(rect.y + 0.5f),
+		(float) entry->w,
+		(float) entry->h
+	};
+
+	if (entry->texture != NULL) {
+		if (GeometryBatch_reserve(renderer, entry->texture, 4, 6) >= 0) {
+			GeometryBatch_pushQuad(dst, (SDL_FRect){0, 0, 1, 1}, white);
+		}
+		return;
+	}
+
+	// Strings sharing a ring page are drawn in one batch
+	const float inv_size = 1.0f / (float) SDLCLAY_UPLOAD_RING_PAGE_SIZE;
+	const SDL_FRect uv = {
+		(float) entry->slot.src.x * inv_size,
+		(float) entry->slot.src.y * inv_size,
+		(float) entry->slot.src.w * inv_size,
+		(float) entry->slot.src.h * inv_size
+	};
+	if (GeometryBatch_reserve(renderer, UploadRing_texture(&entry->slot), 4, 6) >= 0) {
+		GeometryBatch_pushQuad(dst, uv, white);
+	}
+}
+
+static void SDLCLAY_RenderText(
+	SDL_Renderer* renderer,
+	const Clay_TextRenderData* config,
+	const SDL_FRect rect
+) {
+	switch (TEXT_MODE) {
+		case SDLCLAY_TEXT_MODE_STRING_CACHE:
+			TextCache_renderText(renderer, config, rect);
+			break;
+		case SDLCLAY_TEXT_MODE_SCALABLE:
+			GlyphAtlas_renderText(renderer, config, rect, SDLCLAY_RasterSize(config->fontSize));
+			break;
+		case SDLCLAY_TEXT_MODE_GLYPH_ATLAS:
+		default:
+			GlyphAtlas_renderText(renderer, config, rect, config->fontSize);
+			break;
+	}
+}
+
+// ===================================================================================
+// MARK: RENDER STATE
+// ===================================================================================
+
+/**
+ * Shadow of the renderer state touched while drawing commands, setters skip
+ * the SDL call when the value is unchanged. Pending geometry was batched under
+ * the previous state, so it is flushed before any call is actually issued.
+ */
+static struct RenderState {
+	SDL_Renderer* renderer;
+	SDL_Texture* target;
+	SDL_Color color;
+	SDL_BlendMode blend_mode;
+	SDL_Rect clip;
+	bool clip_enabled;
+} RENDER_STATE = {0};
+
+/**
+ * Read the clip of the current target, each render target has its own
+ */
+static void RenderState_syncClip() {
+	RENDER_STATE.clip_enabled = SDL_RenderClipEnabled(RENDER_STATE.renderer);
+	SDL_GetRenderClipRect(RENDER_STATE.renderer, &RENDER_STATE.clip);
+}
+
+/**
+ * Start tracking the renderer, the caller may have changed anything since the last frame
+ */
+static void RenderState_begin(SDL_Renderer* renderer) {
+	RENDER_STATE.renderer = renderer;
+	RENDER_STATE.target = SDL_GetRenderTarget(renderer);
+	SDL_GetRenderDrawColor(
+		renderer,
+		&RENDER_STATE.color.r,
+		&RENDER_STATE.color.g,
+		&RENDER_STATE.color.b,
+		&RENDER_STATE.color.a
+	);
+	SDL_GetRenderDrawBlendMode(renderer, &RENDER_STATE.blend_mode);
+	RenderState_syncClip();
+}
+
+static bool RenderState_issue(const bool changed) {
+	if (!changed) {
+		STATS.state_calls_elided++;
+		return false;
+	}
+
+	GeometryBatch_flush(RENDER_STATE.renderer);
+	STATS.state_calls_issued++;
+	return true;
+}
+
+static void RenderState_setTarget(SDL_Texture* target) {
+	if (RenderState_issue(RENDER_STATE.target != target)) {
+		SDL_SetRenderTarget(RENDER_STATE.renderer, target);
+		RENDER_STATE.target = target;
+		RenderState_syncClip();
+	}
+}
+
+static void RenderState_setColor(const SDL_Color color) {
+	const bool changed =
+		RENDER_STATE.color.r != color.r || RENDER_STATE.color.g != color.g ||
+		RENDER_STATE.color.b != color.b || RENDER_STATE.color.a != color.a;
+
+	if (RenderState_issue(changed)) {
+		SDL_SetRenderDrawColor(RENDER_STATE.renderer, color.r, color.g, color.b, color.a);
+		RENDER_STATE.color = color;
+	}
+}
+
+static void RenderState_setBlendMode(const SDL_BlendMode blend_mode) {
+	if (RenderState_issue(RENDER_STATE.blend_mode != blend_mode)) {
+		SDL_SetRenderDrawBlendMode(RENDER_STATE.renderer, blend_mode);
+		RENDER_STATE.blend_mode = blend_mode;
+	}
+}
+
+/**
+ * @param clip Clip rect to set, NULL to disable clipping
+ */
+static void RenderState_setClip(const SDL_Rect* clip) {
+	const bool changed = clip == NULL
+		? RENDER_STATE.clip_enabled
+		: !RENDER_STATE.clip_enabled || !SDL_RectsEqual(&RENDER_STATE.clip, clip);
+
+	if (RenderState_issue(changed)) {
+		SDL_SetRenderClipRect(RENDER_STATE.renderer, clip);
+		RENDER_STATE.clip_enabled = clip != NULL;
+		RENDER_STATE.clip = clip != NULL ? *clip : (SDL_Rect){0};
+	}
+}
+
+// ===================================================================================
+// MARK: CLIP
+// ===================================================================================
+
+/**
+ * Nested scissors, each entry is the intersection of its rect with the parent one.
+ * The base entry is the viewport, or the damaged area being redrawn, so commands
+ * outside of it are culled like clipped ones.
+ */
+static struct ClipStack {
+	SDL_Rect rects[SDLCLAY_CLIP_STACK_CAPACITY];
+	int count;
+	// Scissors pushed past the capacity, they keep the clip of the deepest entry
+	int overflow;
+	// Whether the base entry needs a clip rect, the viewport clips by itself
+	bool clip_base;
+} CLIP_STACK = {0};
+
+static void ClipStack_reset(const SDL_Rect base, const bool clip_base) {
+	CLIP_STACK.rects[0] = base;
+	CLIP_STACK.count = 1;
+	CLIP_STACK.overflow = 0;
+	CLIP_STACK.clip_base = clip_base;
+}
+
+static const SDL_Rect* ClipStack_top() {
+	return &CLIP_STACK.rects[CLIP_STACK.count - 1];
+}
+
+static void ClipStack_apply() {
+	RenderState_setClip(CLIP_STACK.count > 1 || CLIP_STACK.clip_base ? ClipStack_top() : NULL);
+}
+
+static void ClipStack_push(const SDL_Rect rect) {
+	if (CLIP_STACK.count == SDLCLAY_CLIP_STACK_CAPACITY) {
+		if (CLIP_STACK.overflow++ == 0) {
+			SDLCLAY_LOG("Scissor nesting exceeds SDLCLAY_CLIP_STACK_CAPACITY (%d)", SDLCLAY_CLIP_STACK_CAPACITY);
+		}
+		return;
+	}
+
+	SDL_Rect clip = {0};
+	if (!SDL_GetRectIntersection(ClipStack_top(), &rect, &clip)) {
+		clip = (SDL_Rect){0};
+	}
+
+	CLIP_STACK.rects[CLIP_STACK.count++] = clip;
+}
+
+static void ClipStack_pop() {
+	if (CLIP_STACK.overflow > 0) {
+		CLIP_STACK.overflow--;
+		return;
+	}
+
+	if (CLIP_STACK.count <= 1) {
+		SDLCLAY_LOG("Unbalanced scissor end");
+		return;
+	}
+
+	CLIP_STACK.count--;
+}
+
+/**
+ * @return true when nothing of rect would survive the active clip
+ */
+static bool ClipStack_culls(const SDL_FRect rect) {
+	const SDL_Rect* clip = ClipStack_top();
+	return clip->w <= 0 || clip->h <= 0 ||
+		rect.x >= (float) (clip->x + clip->w) || rect.x + rect.w <= (float) clip->x ||
+		rect.y >= (float) (clip->y + clip->h) || rect.y + rect.h <= (float) clip->y;
+}
+
+// ===================================================================================
+// MARK: OCCLUSION
+// ===================================================================================
+
+/**
+ * Result of the occlusion pass for each command of the frame
+ */
+typedef struct CommandVisibility {
+	// Part of the bounding box inside the clip of the command
+	SDL_FRect visible;
+	bool occluded;
+} CommandVisibility;
+
+static struct Occlusion {
+	CommandVisibility* commands;
+	int capacity;
+	// Opaque areas drawn by the commands after the current one
+	SDL_FRect occluders[SDLCLAY_OCCLUSION_MAX_OCCLUDERS];
+	int occluder_count;
+} OCCLUSION = {0};
+
+static float SDLCLAY_RectArea(const SDL_FRect rect) {
+	return rect.w > 0 && rect.h > 0 ? rect.w * rect.h : 0.0f;
+}
+
+static bool SDLCLAY_RectContains(const SDL_FRect outer, const SDL_FRect inner) {
+	return inner.x >= outer.x && inner.y >= outer.y &&
+		inner.x + inner.w <= outer.x + outer.w &&
+		inner.y + inner.h <= outer.y + outer.h;
+}
+
+static void Occlusion_addOccluder(const SDL_FRect rect, const SDL_FRect clip) {
+	SDL_FRect occluder;
+	if (!SDL_GetRectIntersectionFloat(&rect, &clip, &occluder)) {
+		return;
+	}
+
+	if (OCCLUSION.occluder_count < SDLCLAY_OCCLUSION_MAX_OCCLUDERS) {
+		OCCLUSION.occluders[OCCLUSION.occluder_count++] = occluder;
+		return;
+	}
+
+	// Keep the largest occluders, they hide the most
+	int smallest = 0;
+	for (int i = 1; i < OCCLUSION.occluder_count; i++) {
+		if (SDLCLAY_RectArea(OCCLUSION.occluders[i]) < SDLCLAY_RectArea(OCCLUSION.occluders[smallest])) {
+			smallest = i;
+		}
+	}
+
+	if (SDLCLAY_RectArea(occluder) > SDLCLAY_RectArea(OCCLUSION.occluders[smallest])) {
+		OCCLUSION.occluders[smallest] = occluder;
+	}
+}
+
+static bool Occlusion_isHidden(const SDL_FRect visible) {
+	for (int i = 0; i < OCCLUSION.occluder_count; i++) {
+		if (SDLCLAY_RectContains(OCCLUSION.occluders[i], visible)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool SDLCLAY_IsOpaqueTexture(SDL_Texture* texture) {
+	const SDLCLAY_Image* image = ImageSet_find(texture);
+	if (image != NULL) {
+		return image->opaque;
+	}
+
+	Uint8 alpha = 0;
+	SDL_BlendMode blend_mode = SDL_BLENDMODE_BLEND;
+	if (texture == NULL || !SDL_GetTextureAlphaMod(texture, &alpha) || !SDL_GetTextureBlendMode(texture, &blend_mode)) {
+		return false;
+	}
+	return alpha == 255 && (blend_mode == SDL_BLENDMODE_NONE || !SDL_ISPIXELFORMAT_ALPHA(texture->format));
+}
+
+/**
+ * Register the opaque area of a command drawn over the ones before it
+ */
+static void Occlusion_addCommand(const Clay_RenderCommand* render_command, const SDL_FRect rect, const SDL_FRect clip) {
+	switch (render_command->commandType) {
+		case CLAY_RENDER_COMMAND_TYPE_RECTANGLE: {
+			const Clay_RectangleRenderData* config = &render_command->renderData.rectangle;
+			if (config->backgroundColor.a < 255.0f) {
+				return;
+			}
+
+			const Clay_CornerRadius r = config->cornerRadius;
+			const float top = SDL_max(r.topLeft, r.topRight);
+			const float bottom = SDL_max(r.bottomLeft, r.bottomRight);
+			const float left = SDL_max(r.topLeft, r.bottomLeft);
+			const float right = SDL_max(r.topRight, r.bottomRight);
+
+			if (top <= 0 && bottom <= 0) {
+				Occlusion_addOccluder(rect, clip);
+				return;
+			}
+
+			// Corners are transparent, only the two bands between them are covered
+			Occlusion_addOccluder((SDL_FRect){rect.x, rect.y + top, rect.w, rect.h - top - bottom}, clip);
+			Occlusion_addOccluder((SDL_FRect){rect.x + left, rect.y, rect.w - left - right, rect.h}, clip);
+		}
+		break;
+		case CLAY_RENDER_COMMAND_TYPE_IMAGE: {
+			if (SDLCLAY_IsOpaqueTexture(render_command->renderData.image.imageData)) {
+				Occlusion_addOccluder(rect, clip);
+			}
+		}
+		break;
+		default:
+			break;
+	}
+}
+
+/**
+ * Walk the commands back to front and flag those entirely hidden by opaque commands drawn later
+ */
+static void Occlusion_run(const Clay_RenderCommandArray* commands_array, const int w, const int h) {
+	const int count = commands_array->length;
+	if (!SDLCLAY_GrowBuffer((void**) &OCCLUSION.commands, &OCCLUSION.capacity, count, sizeof(CommandVisibility))) {
+		return;
+	}
+
+	// Clip of each command, front to back
+	ClipStack_reset((SDL_Rect){0, 0, w, h}, false);
+	for (int i = 0; i < count; i++) {
+		const Clay_RenderCommand* render_command = Clay_RenderCommandArray_Get((Clay_RenderCommandArray*) commands_array, i);
+		const Clay_BoundingBox box = render_command->boundingBox;
+		CommandVisibility* command = &OCCLUSION.commands[i];
+		command->occluded = false;
+
+		if (render_command->commandType == CLAY_RENDER_COMMAND_TYPE_SCISSOR_START) {
+			ClipStack_push((SDL_Rect){(int) box.x, (int) box.y, (int) box.width, (int) box.height});
+		} else if (render_command->commandType == CLAY_RENDER_COMMAND_TYPE_SCISSOR_END) {
+			ClipStack_pop();
+		}
+
+		const SDL_Rect* clip = ClipStack_top();
+		const SDL_FRect f_clip = {(float) clip->x, (float) clip->y, (float) clip->w, (float) clip->h};
+		const SDL_FRect rect = {box.x, box.y, box.width, box.height};
+		if (!SDL_GetRectIntersectionFloat(&rect, &f_clip, &command->visible)) {
+			command->visible = (SDL_FRect){0};
+		}
+	}
+
+	OCCLUSION.occluder_count = 0;
+	for (int i = count - 1; i >= 0; i--) {
+		const Clay_RenderCommand* render_command = Clay_RenderCommandArray_Get((Clay_RenderCommandArray*) commands_array, i);
+		const Clay_RenderCommandType type = render_command->commandType;
+		CommandVisibility* command = &OCCLUSION.commands[i];
+
+		// Scissors are kept to balance the clip stack, empty commands are left to the clip culling
+		if (type == CLAY_RENDER_COMMAND_TYPE_SCISSOR_START || type == CLAY_RENDER_COMMAND_TYPE_SCISSOR_END) {
+			continue;
+		}
+		if (SDLCLAY_RectArea(command->visible) <= 0) {
+			continue;
+		}
+
+		if (Occlusion_isHidden(command->visible)) {
+			command->occluded = true;
+			continue;
+		}
+
+		const Clay_BoundingBox box = render_command->boundingBox;
+		Occlusion_addCommand(render_command, (SDL_FRect){box.x, box.y, box.width, box.height}, command->visible);
+	}
+}
+
+static void Occlusion_free() {
+	SDLCLAY_FREE(OCCLUSION.commands);
+	SDL_memset(&OCCLUSION, 0, sizeof(OCCLUSION));
+}
+
+// ===================================================================================
+// MARK: FINGERPRINT
+// ===================================================================================
+
+static struct Fingerprint {
+	// Hash of the last frame drawn by SDLCLAY_RenderCommands
+	uint64_t frame;
+	bool valid;
+} FINGERPRINT = {0};
+
+/**
+ * Hash and bounding box of a command, kept to diff consecutive frames
+ */
+typedef struct CommandRecord {
+	uint64_t hash;
+	SDL_FRect box;
+} CommandRecord;
+
+static uint64_t SDLCLAY_HashContinue(uint64_t hash, const void* bytes, const size_t length) {
+	// FNV-1a 64 bits
+	const uint8_t* data = bytes;
+	for (size_t i = 0; i < length; i++) {
+		hash ^= data[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+#define SDLCLAY_HASH_INIT 14695981039346656037ull
+#define SDLCLAY_HASH_VALUE(hash, value) SDLCLAY_HashContinue(hash, &(value), sizeof(value))
+
+/**
+ * Hash everything a command draws with, fields are hashed one by one
+ * since the padding of Clay render data is not initialized
+ *
+ * @param origin Position the bounding box is hashed relative to
+ */
+static uint64_t Fingerprint_command(const Clay_RenderCommand* render_command, const SDL_FPoint origin) {
+	// Quantized to 1/16 pixel, so rounding errors of relative positions hash the same
+	const Clay_BoundingBox box = render_command->boundingBox;
+	const int32_t relative_box[4] = {
+		(int32_t) SDL_roundf((box.x - origin.x) * 16.0f),
+		(int32_t) SDL_roundf((box.y - origin.y) * 16.0f),
+		(int32_t) SDL_roundf(box.width * 16.0f),
+		(int32_t) SDL_roundf(box.height * 16.0f)
+	};
+
+	uint64_t hash = SDLCLAY_HASH_INIT;
+	hash = SDLCLAY_HASH_VALUE(hash, render_command->commandType);
+	hash = SDLCLAY_HASH_VALUE(hash, relative_box);
+
+	switch (render_command->commandType) {
+		case CLAY_RENDER_COMMAND_TYPE_RECTANGLE: {
+			const Clay_RectangleRenderData* config = &render_command->renderData.rectangle;
+			hash = SDLCLAY_HASH_VALUE(hash, config->backgroundColor);
+			hash = SDLCLAY_HASH_VALUE(hash, config->cornerRadius);
+		}
+		break;
+		case CLAY_RENDER_COMMAND_TYPE_TEXT: {
+			const Clay_TextRenderData* config = &render_command->renderData.text;
+			// Text is hashed by content, the chars may live in a reused buffer
+			hash = SDLCLAY_HashContinue(hash, config->stringContents.chars, (size_t) config->stringContents.length);
+			hash = SDLCLAY_HASH_VALUE(hash, config->stringContents.length);
+			hash = SDLCLAY_HASH_VALUE(hash, config->textColor);
+			hash = SDLCLAY_HASH_VALUE(hash, config->fontId);
+			hash = SDLCLAY_HASH_VALUE(hash, config->fontSize);
+			hash = SDLCLAY_HASH_VALUE(hash, config->letterSpacing);
+			hash = SDLCLAY_HASH_VALUE(hash, config->lineHeight);
+		}
+		break;
+		case CLAY_RENDER_COMMAND_TYPE_BORDER: {
+			const Clay_BorderRenderData* config = &render_command->renderData.border;
+			hash = SDLCLAY_HASH_VALUE(hash, config->color);
+			hash = SDLCLAY_HASH_VALUE(hash, config->cornerRadius);
+			hash = SDLCLAY_HASH_VALUE(hash, config->width.left);
+			hash = SDLCLAY_HASH_VALUE(hash, config->width.right);
+			hash = SDLCLAY_HASH_VALUE(hash, config->width.top);
+			hash = SDLCLAY_HASH_VALUE(hash, config->width.bottom);
+			hash = SDLCLAY_HASH_VALUE(hash, config->width.betweenChildren);
+		}
+		break;
+		case CLAY_RENDER_COMMAND_TYPE_IMAGE: {
+			const Clay_ImageRenderData* config = &render_command->renderData.image;
+			hash = SDLCLAY_HASH_VALUE(hash, config->backgroundColor);
+			hash = SDLCLAY_HASH_VALUE(hash, config->cornerRadius);
+			hash = SDLCLAY_HASH_VALUE(hash, config->imageData);
+		}
+		break;
+		default:
+			break;
+	}
+
+	return hash;
+}
+
+/**
+ * Hash of the settings changing how commands look, cached pixels drawn with other ones are stale
+ */
+static uint64_t Fingerprint_style() {
+	uint64_t hash = SDLCLAY_HASH_INIT;
+	hash = SDLCLAY_HASH_VALUE(hash, TEXT_MODE);
+	hash = SDLCLAY_HASH_VALUE(hash, CORNER_TOLERANCE);
+	hash = SDLCLAY_HASH_VALUE(hash, SHAPE_MODE);
+	hash = SDLCLAY_HASH_VALUE(hash, GLYPH_WORKERS.generation);
+	return hash;
+}
+
+/**
+ * Hash of the output and settings commands are drawn with
+ */
+static uint64_t Fingerprint_settings(SDL_Renderer* renderer) {
+	int w = 0, h = 0;
+	float scale_x = 1.0f, scale_y = 1.0f;
+	SDL_GetCurrentRenderOutputSize(renderer, &w, &h);
+	SDL_GetRenderScale(renderer, &scale_x, &scale_y);
+
+	uint64_t hash = SDLCLAY_HASH_INIT;
+	hash = SDLCLAY_HASH_VALUE(hash, renderer);
+	hash = SDLCLAY_HASH_VALUE(hash, w);
+	hash = SDLCLAY_HASH_VALUE(hash, h);
+	hash = SDLCLAY_HASH_VALUE(hash, scale_x);
+	hash = SDLCLAY_HASH_VALUE(hash, scale_y);
+	hash = SDLCLAY_HASH_VALUE(hash, RENDER_MODE);
+	const uint64_t style = Fingerprint_style();
+	hash = SDLCLAY_HASH_VALUE(hash, style);
+	return hash;
+}
+
+/**
+ * Hash of a whole frame, including the output and settings it is drawn with
+ *
+ * @param records When not NULL, receives the hash and bounding box of each command
+ */
+static uint64_t Fingerprint_frame(
+	Clay_RenderCommandArray* commands_array,
+	const uint64_t settings,
+	CommandRecord* records
+) {
+	uint64_t hash = settings;
+
+	for (int32_t i = 0; i < commands_array->length; i++) {
+		const Clay_RenderCommand* render_command = Clay_RenderCommandArray_Get(commands_array, i);
+		const uint64_t command_hash = Fingerprint_command(render_command, (SDL_FPoint){0, 0});
+		hash = SDLCLAY_HASH_VALUE(hash, command_hash);
+
+		if (records != NULL) {
+			const Clay_BoundingBox box = render_command->boundingBox;
+			records[i] = (CommandRecord){command_hash, {box.x, box.y, box.width, box.height}};
+		}
+	}
+
+	return hash;
+}
+
+bool SDLCLAY_IsFrameUnchanged(SDL_Renderer* renderer, Clay_RenderCommandArray* commands_array) {
+	if (GlyphWorkers_hasUpdates()) {
+		return false;
+	}
+	return FINGERPRINT.valid && FINGERPRINT.frame == Fingerprint_frame(commands_array, Fingerprint_settings(renderer), NULL);
+}
+
+void SDLCLAY_InvalidateFrame() {
+	FINGERPRINT.valid = false;
+}
+
+// ===================================================================================
+// MARK: RENDER TARGET
+// ===================================================================================
+
+static struct RenderTarget {
+	SDL_Renderer* renderer;
+	SDL_Texture* texture;
+	// Allocated size, can be larger than the output size
+	int w;
+	int h;
+	// Frames the output has been small enough to shrink the texture
+	int shrink_frames;
+	// Set when the texture is created, its content must be redrawn entirely
+	bool content_lost;
+} RENDER_TARGET = {0};
+
+static int SDLCLAY_RoundUp(const int value, const int granularity) {
+	return (value + granularity - 1) / granularity * granularity;
+}
+
+/**
+ * Get the composition target for an output of w*h pixels. The texture only grows
+ * in SDLCLAY_RENDER_TARGET_GRANULARITY steps and only shrinks once the output has
+ * been less than half its size for SDLCLAY_RENDER_TARGET_SHRINK_DELAY frames,
+ * so a resize storm does not recreate it every frame.
+ */
+static SDL_Texture* RenderTarget_acquire(SDL_Renderer* renderer, const int w, const int h) {
+	if (RENDER_TARGET.renderer != renderer) {
+		SDLCLAY_ReleaseRenderTarget();
+	}
+
+	const bool too_small = RENDER_TARGET.texture == NULL || w > RENDER_TARGET.w || h > RENDER_TARGET.h;
+	const bool too_large = w * 2 < RENDER_TARGET.w || h * 2 < RENDER_TARGET.h;
+
+	RENDER_TARGET.shrink_frames = too_large ? RENDER_TARGET.shrink_frames + 1 : 0;
+
+	if (too_small || RENDER_TARGET.shrink_frames > SDLCLAY_RENDER_TARGET_SHRINK_DELAY) {
+		SDLCLAY_ReleaseRenderTarget();
+
+		const int new_w = SDLCLAY_RoundUp(SDL_max(w, 1), SDLCLAY_RENDER_TARGET_GRANULARITY);
+		const int new_h = SDLCLAY_RoundUp(SDL_max(h, 1), SDLCLAY_RENDER_TARGET_GRANULARITY);
+
+		RENDER_TARGET.texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, new_w, new_h);
+		if (RENDER_TARGET.texture == NULL) {
+			SDLCLAY_LOG("Failed to create render target %dx%d: %s", new_w, new_h, SDL_GetError());
+			return NULL;
+		}
+
+		RENDER_TARGET.renderer = renderer;
+		RENDER_TARGET.w = new_w;
+		RENDER_TARGET.h = new_h;
+		RENDER_TARGET.content_lost = true;
+	}
+
+	return RENDER_TARGET.texture;
+}
+
+void SDLCLAY_ReleaseRenderTarget() {
+	if (RENDER_TARGET.texture != NULL) {
+		SDL_DestroyTexture(RENDER_TARGET.texture);
+	}
+	SDL_memset(&RENDER_TARGET, 0, sizeof(RENDER_TARGET));
+}
+
+// ===================================================================================
+// MARK: DAMAGE
+// ===================================================================================
+
+// Margin around damaged commands, for glyphs overhanging their bounding box
+#define SDLCLAY_DAMAGE_PADDING 2
+
+/**
+ * Commands of the last frame drawn into the render target, diffed index by index
+ * with the current ones to redraw only the areas that changed
+ */
+static struct Damage {
+	CommandRecord* records;
+	CommandRecord* previous_records;
+	int capacity;
+	int previous_capacity;
+	int previous_count;
+	uint64_t previous_settings;
+	bool valid;
+	SDL_Rect rects[SDLCLAY_DAMAGE_MAX_RECTS];
+	int rect_count;
+} DAMAGE = {0};
+
+/**
+ * @return Buffer receiving the records of the current frame, or NULL on allocation failure
+ */
+static CommandRecord* Damage_records(const int count) {
+	if (!SDLCLAY_GrowBuffer((void**) &DAMAGE.records, &DAMAGE.capacity, count, sizeof(CommandRecord))) {
+		DAMAGE.valid = false;
+		return NULL;
+	}
+	return DAMAGE.records;
+}
+
+static void Damage_add(const SDL_FRect box, const int w, const int h) {
+	if (box.w <= 0 || box.h <= 0) {
+		return;
+	}
+
+	const int x0 = SDL_max((int) SDL_floorf(box.x) - SDLCLAY_DAMAGE_PADDING, 0);
+	const int y0 = SDL_max((int) SDL_floorf(box.y) - SDLCLAY_DAMAGE_PADDING, 0);
+	const int x1 = SDL_min((int) SDL_ceilf(box.x + box.w) + SDLCLAY_DAMAGE_PADDING, w);
+	const int y1 = SDL_min((int) SDL_ceilf(box.y + box.h) + SDLCLAY_DAMAGE_PADDING, h);
+	if (x1 <= x0 || y1 <= y0) {
+		return;
+	}
+
+	SDL_Rect rect = {x0, y0, x1 - x0, y1 - y0};
+
+	// Merge overlapping rects, or the one growing the least once the set is full
+	for (;;) {
+		int merge = -1;
+		for (int i = 0; i < DAMAGE.rect_count && merge < 0; i++) {
+			if (SDL_HasRectIntersection(&DAMAGE.rects[i], &rect)) {
+				merge = i;
+			}
+		}
+
+		if (merge < 0 && DAMAGE.rect_count == SDLCLAY_DAMAGE_MAX_RECTS) {
+			int64_t best_growth = INT64_MAX;
+			for (int i = 0; i < DAMAGE.rect_count; i++) {
+				SDL_Rect merged;
+				SDL_GetRectUnion(&DAMAGE.rects[i], &rect, &merged);
+				const int64_t growth = (int64_t) merged.w * merged.h - (int64_t) DAMAGE.rects[i].w * DAMAGE.rects[i].h;
+				if (growth < best_growth) {
+					best_growth = growth;
+					merge = i;
+				}
+			}
+		}
+
+		if (merge < 0) {
+			break;
+		}
+
+		SDL_GetRectUnion(&DAMAGE.rects[merge], &rect, &rect);
+		DAMAGE.rects[merge] = DAMAGE.rects[--DAMAGE.rect_count];
+	}
+
+	DAMAGE.rects[DAMAGE.rect_count++] = rect;
+}
+
+/**
+ * Diff the records of the current frame with the previous one and keep them for the next frame.
+ *
+ * @return true if only DAMAGE.rects need to be redrawn, false for a full redraw
+ */
+static bool Damage_compute(const uint64_t settings, const int count, const int w, const int h) {
+	DAMAGE.rect_count = 0;
+
+	bool partial = DAMAGE.valid && !RENDER_TARGET.content_lost &&
+		DAMAGE.previous_settings == settings && DAMAGE.previous_count == count;
+
+	for (int i = 0; i < count && partial; i++) {
+		const CommandRecord* current = &DAMAGE.records[i];
+		const CommandRecord* previous = &DAMAGE.previous_records[i];
+		if (current->hash != previous->hash) {
+			// Redraw where the command was and where it is now
+			Damage_add(previous->box, w, h);
+			Damage_add(current->box, w, h);
+		}
+	}
+
+	if (partial) {
+		int64_t damaged = 0;
+		for (int i = 0; i < DAMAGE.rect_count; i++) {
+			damaged += (int64_t) DAMAGE.rects[i].w * DAMAGE.rects[i].h;
+		}
+		partial = (float) damaged <= SDLCLAY_DAMAGE_MAX_COVERAGE * (float) w * (float) h;
+	}
+
+	// Current records become the previous ones
+	CommandRecord* records = DAMAGE.previous_records;
+	const int capacity = DAMAGE.previous_capacity;
+	DAMAGE.previous_records = DAMAGE.records;
+	DAMAGE.previous_capacity = DAMAGE.capacity;
+	DAMAGE.records = records;
+	DAMAGE.capacity = capacity;
+	DAMAGE.previous_count = count;
+	DAMAGE.previous_settings = settings;
+	DAMAGE.valid = true;
+	RENDER_TARGET.content_lost = false;
+
+	return partial;
+}
+
+static void Damage_free() {
+	SDLCLAY_FREE(DAMAGE.records);
+	SDLCLAY_FREE(DAMAGE.previous_records);
+	SDL_memset(&DAMAGE, 0, sizeof(DAMAGE));
+}
+
+// ===================================================================================
+// MARK: LAYERS
+// ===================================================================================
+
+/**
+ * Element whose commands are drawn once into a texture and blitted
+ * until the fingerprint of its commands changes
+ */
+typedef struct Layer {
+	uint32_t id;
+	// Commands of the element this frame, begin is -1 when it is not laid out
+	int begin;
+	int end;
+	// Pixel aligned area covered by the commands
+	SDL_Rect rect;
+	SDL_Texture* texture;
+	// Fingerprint of the commands drawn in the texture, relative to rect
+	uint64_t hash;
+	uint64_t last_frame;
+} Layer;
+
+static struct Layers {
+	SDL_Renderer* renderer;
+	Layer layers[SDLCLAY_LAYER_MAX_COUNT];
+	int count;
+	// Textures of evicted or resized layers, reused before creating new ones
+	SDL_Texture* pool[SDLCLAY_LAYER_MAX_COUNT];
+	int pool_count;
+	// Memory of every layer and pooled texture
+	size_t bytes;
+} LAYERS = {0};
+
+static size_t SDLCLAY_TextureBytes(const SDL_Texture* texture) {
+	return (size_t) texture->w * (size_t) texture->h * 4;
+}
+
+static void Layers_destroyTexture(SDL_Texture* texture) {
+	LAYERS.bytes -= SDLCLAY_TextureBytes(texture);
+	SDL_DestroyTexture(texture);
+}
+
+static void Layers_releaseTexture(SDL_Texture* texture) {
+	if (texture == NULL) {
+		return;
+	}
+
+	if (LAYERS.pool_count < SDLCLAY_LAYER_MAX_COUNT) {
+		LAYERS.pool[LAYERS.pool_count++] = texture;
+	} else {
+		Layers_destroyTexture(texture);
+	}
+}
+
+/**
+ * Get a texture of at least w*h pixels, the smallest fitting one of the pool
+ * or a new one rounded up to SDLCLAY_LAYER_GRANULARITY
+ */
+static SDL_Texture* Layers_acquireTexture(SDL_Renderer* renderer, const int w, const int h) {
+	int best = -1;
+	for (int i = 0; i < LAYERS.pool_count; i++) {
+		const SDL_Texture* texture = LAYERS.pool[i];
+		if (texture->w >= w && texture->h >= h && (best < 0 || SDLCLAY_TextureBytes(texture) < SDLCLAY_TextureBytes(LAYERS.pool[best]))) {
+			best = i;
+		}
+	}
+
+	if (best >= 0) {
+		SDL_Texture* texture = LAYERS.pool[best];
+		LAYERS.pool[best] = LAYERS.pool[--LAYERS.pool_count];
+		return texture;
+	}
+
+	const int new_w = SDLCLAY_RoundUp(w, SDLCLAY_LAYER_GRANULARITY);
+	const int new_h = SDLCLAY_RoundUp(h, SDLCLAY_LAYER_GRANULARITY);
+	SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, new_w, new_h);
+	if (texture == NULL) {
+		SDLCLAY_LOG("Failed to create layer texture %dx%d: %s", new_w, new_h, SDL_GetError());
+		return NULL;
+	}
+
+	// Commands blended over a transparent texture leave premultiplied colors
+	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND_PREMULTIPLIED);
+	SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_NEAREST);
+	LAYERS.bytes += SDLCLAY_TextureBytes(texture);
+	return texture;
+}
+
+/**
+ * Evict pooled textures then least recently drawn layers until the budget is met,
+ * layers drawn this frame are kept
+ */
+static void Layers_trim() {
+	while (LAYERS.bytes > SDLCLAY_LAYER_CACHE_BUDGET && LAYERS.pool_count > 0) {
+		Layers_destroyTexture(LAYERS.pool[--LAYERS.pool_count]);
+	}
+
+	while (LAYERS.bytes > SDLCLAY_LAYER_CACHE_BUDGET) {
+		Layer* oldest = NULL;
+		for (int i = 0; i < LAYERS.count; i++) {
+			Layer* layer = &LAYERS.layers[i];
+			if (layer->texture != NULL && layer->last_frame != FRAME_INDEX && (oldest == NULL || layer->last_frame < oldest->last_frame)) {
+				oldest = layer;
+			}
+		}
+
+		if (oldest == NULL) {
+			return;
+		}
+
+		Layers_destroyTexture(oldest->texture);
+		oldest->texture = NULL;
+		STATS.layer_evictions++;
+	}
+}
+
+static void Layers_releaseAll() {
+	for (int i = 0; i < LAYERS.count; i++) {
+		if (LAYERS.layers[i].texture != NULL) {
+			Layers_destroyTexture(LAYERS.layers[i].texture);
+			LAYERS.layers[i].texture = NULL;
+		}
+	}
+	while (LAYERS.pool_count > 0) {
+		Layers_destroyTexture(LAYERS.pool[--LAYERS.pool_count]);
+	}
+}
+
+static bool SDLCLAY_BoxContains(const Clay_BoundingBox outer, const Clay_BoundingBox inner) {
+	// Half a pixel of slack for rounding in the layout
+	return inner.x >= outer.x - 0.5f && inner.y >= outer.y - 0.5f &&
+		inner.x + inner.width <= outer.x + outer.width + 0.5f &&
+		inner.y + inner.height <= outer.y + outer.height + 0.5f;
+}
+
+/**
+ * Find the commands of a layer, they start with the first command of the element
+ * and go on while commands stay within its bounding box and scissors are balanced
+ */
+static void Layer_resolve(Layer* layer, Clay_RenderCommandArray* commands_array, const int first) {
+	const Clay_RenderCommand* first_command = Clay_RenderCommandArray_Get(commands_array, first);
+	const Clay_BoundingBox box = first_command->boundingBox;
+
+	int depth = first_command->commandType == CLAY_RENDER_COMMAND_TYPE_SCISSOR_START ? 1 : 0;
+	int end = depth == 0 ? first + 1 : -1;
+
+	for (int i = first + 1; i < commands_array->length; i++) {
+		const Clay_RenderCommand* render_command = Clay_RenderCommandArray_Get(commands_array, i);
+		if (render_command->commandType == CLAY_RENDER_COMMAND_TYPE_SCISSOR_END) {
+			if (depth == 0) {
+				break;
+			}
+			depth--;
+		} else if (!SDLCLAY_BoxContains(box, render_command->boundingBox)) {
+			break;
+		} else if (render_command->commandType == CLAY_RENDER_COMMAND_TYPE_SCISSOR_START) {
+			depth++;
+		}
+
+		if (depth == 0) {
+			end = i + 1;
+		}
+	}
+
+	if (end < 0) {
+		return;
+	}
+
+	const int x0 = (int) SDL_floorf(box.x);
+	const int y0 = (int) SDL_floorf(box.y);
+	layer->begin = first;
+	layer->end = end;
+	layer->rect = (SDL_Rect){x0, y0, (int) SDL_ceilf(box.x + box.width) - x0, (int) SDL_ceilf(box.y + box.height) - y0};
+}
+
+static void Layers_resolve(Clay_RenderCommandArray* commands_array) {
+	for (int i = 0; i < LAYERS.count; i++) {
+		LAYERS.layers[i].begin = -1;
+	}
+
+	for (int32_t i = 0; i < commands_array->length; i++) {
+		const uint32_t id = Clay_RenderCommandArray_Get(commands_array, i)->id;
+		for (int j = 0; j < LAYERS.count; j++) {
+			Layer* layer = &LAYERS.layers[j];
+			if (layer->id == id && layer->begin < 0) {
+				Layer_resolve(layer, commands_array, i);
+				break;
+			}
+		}
+	}
+}
+
+/**
+ * @return Layer whose commands start at index and that can be blitted, NULL otherwise
+ */
+static Layer* Layers_at(const int index) {
+	for (int i = 0; i < LAYERS.count; i++) {
+		Layer* layer = &LAYERS.layers[i];
+		if (layer->begin == index && layer->texture != NULL && layer->last_frame == FRAME_INDEX) {
+			return layer;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Hash of the commands of a layer relative to its position, so moving it keeps the texture
+ */
+static uint64_t Layer_fingerprint(const Layer* layer, Clay_RenderCommandArray* commands_array) {
+	const SDL_FPoint origin = {(float) layer->rect.x, (float) layer->rect.y};
+
+	uint64_t hash = SDLCLAY_HASH_INIT;
+	hash = SDLCLAY_HASH_VALUE(hash, layer->rect.w);
+	hash = SDLCLAY_HASH_VALUE(hash, layer->rect.h);
+	const uint64_t style = Fingerprint_style();
+	hash = SDLCLAY_HASH_VALUE(hash, style);
+
+	for (int i = layer->begin; i < layer->end; i++) {
+		const uint64_t command_hash = Fingerprint_command(Clay_RenderCommandArray_Get(commands_array, i), origin);
+		hash = SDLCLAY_HASH_VALUE(hash, command_hash);
+	}
+
+	return hash;
+}
+
+void SDLCLAY_SetLayerCached(const Clay_ElementId element_id, const bool cached) {
+	for (int i = 0; i < LAYERS.count; i++) {
+		if (LAYERS.layers[i].id != element_id.id) {
+			continue;
+		}
+
+		if (!cached) {
+			Layers_releaseTexture(LAYERS.layers[i].texture);
+			LAYERS.layers[i] = LAYERS.layers[--LAYERS.count];
+		}
+		return;
+	}
+
+	if (!cached) {
+		return;
+	}
+
+	if (LAYERS.count == SDLCLAY_LAYER_MAX_COUNT) {
+		SDLCLAY_LOG("Cannot cache more than SDLCLAY_LAYER_MAX_COUNT (%d) layers", SDLCLAY_LAYER_MAX_COUNT);
+		return;
+	}
+
+	LAYERS.layers[LAYERS.count++] = (Layer){.id = element_id.id, .begin = -1};
+}
+
+static void Layers_free() {
+	Layers_releaseAll();
+	SDL_memset(&LAYERS, 0, sizeof(LAYERS));
+}
+
+// ===================================================================================
+// MARK: SCROLL CACHE
+// ===================================================================================
+
+/**
+ * Content of a scroll container drawn in a texture as large as the content,
+ * blitted at the scroll position so scrolling only draws the newly exposed strips
+ */
+typedef struct ScrollCache {
+	uint32_t id;
+	// Content commands this frame, between the container background and its border.
+	// begin is -1 when the container is not laid out or cannot be cached.
+	int begin;
+	int end;
+	// Screen position of the content origin this frame
+	SDL_FPoint origin;
+	// Area of the content visible this frame, in content space
+	SDL_Rect visible;
+	SDL_Texture* texture;
+	// Area of the texture holding up to date content, in content space
+	SDL_Rect valid;
+	// Style the valid area was drawn with
+	uint64_t style;
+	// Commands drawn in the texture, boxes relative to the content origin
+	CommandRecord* records;
+	int record_count;
+	int record_capacity;
+} ScrollCache;
+
+static struct ScrollCaches {
+	ScrollCache caches[SDLCLAY_SCROLL_CACHE_MAX_COUNT];
+	int count;
+	// Records of the content commands of the frame
+	CommandRecord* current;
+	int current_capacity;
+} SCROLL_CACHES = {0};
+
+static void ScrollCache_reset(ScrollCache* cache) {
+	cache->valid = (SDL_Rect){0};
+	cache->record_count = 0;
+}
+
+static bool SDLCLAY_BoxesEqual(const Clay_BoundingBox a, const Clay_BoundingBox b) {
+	return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+}
+
+/**
+ * Find the content commands of a container whose scissor starts at first
+ */
+static void ScrollCache_resolve(ScrollCache* cache, Clay_RenderCommandArray* commands_array, const int first, const int w, const int h) {
+	const Clay_BoundingBox box = Clay_RenderCommandArray_Get(commands_array, first)->boundingBox;
+
+	int last = -1;
+	int depth = 0;
+	for (int i = first + 1; i < commands_array->length && last < 0; i++) {
+		const Clay_RenderCommandType type = Clay_RenderCommandArray_Get(commands_array, i)->commandType;
+		if (type == CLAY_RENDER_COMMAND_TYPE_SCISSOR_START) {
+			depth++;
+		} else if (type == CLAY_RENDER_COMMAND_TYPE_SCISSOR_END && depth-- == 0) {
+			last = i;
+		}
+	}
+
+	const Clay_ScrollContainerData data = Clay_GetScrollContainerData((Clay_ElementId){.id = cache->id});
+	if (last < 0 || !data.found) {
+		return;
+	}
+
+	// The background and border of the container do not scroll, they are drawn as usual
+	int begin = first + 1;
+	int end = last;
+	const Clay_RenderCommand* background = Clay_RenderCommandArray_Get(commands_array, begin);
+	if (begin < end && background->commandType == CLAY_RENDER_COMMAND_TYPE_RECTANGLE && background->id == cache->id) {
+		begin++;
+	}
+	const Clay_RenderCommand* border = Clay_RenderCommandArray_Get(commands_array, end - 1);
+	if (begin < end && border->commandType == CLAY_RENDER_COMMAND_TYPE_BORDER && SDLCLAY_BoxesEqual(border->boundingBox, box)) {
+		end--;
+	}
+
+	const int content_w = (int) SDL_ceilf(data.contentDimensions.width);
+	const int content_h = (int) SDL_ceilf(data.contentDimensions.height);
+	if (content_w <= 0 || content_h <= 0 || content_w > SDLCLAY_SCROLL_CACHE_MAX_SIZE || content_h > SDLCLAY_SCROLL_CACHE_MAX_SIZE) {
+		return;
+	}
+
+	cache->origin = (SDL_FPoint){box.x + data.scrollPosition->x, box.y + data.scrollPosition->y};
+
+	// Visible part of the container, in content space
+	const int x0 = SDL_max((int) SDL_floorf(SDL_max(box.x, 0) - cache->origin.x), 0);
+	const int y0 = SDL_max((int) SDL_floorf(SDL_max(box.y, 0) - cache->origin.y), 0);
+	const int x1 = SDL_min((int) SDL_ceilf(SDL_min(box.x + box.width, (float) w) - cache->origin.x), content_w);
+	const int y1 = SDL_min((int) SDL_ceilf(SDL_min(box.y + box.height, (float) h) - cache->origin.y), content_h);
+	if (x1 <= x0 || y1 <= y0) {
+		return;
+	}
+
+	cache->visible = (SDL_Rect){x0, y0, x1 - x0, y1 - y0};
+	cache->begin = begin;
+	cache->end = end;
+}
+
+static void ScrollCaches_resolve(Clay_RenderCommandArray* commands_array, const int w, const int h) {
+	for (int i = 0; i < SCROLL_CACHES.count; i++) {
+		SCROLL_CACHES.caches[i].begin = -1;
+	}
+
+	for (int32_t i = 0; i < commands_array->length; i++) {
+		const Clay_RenderCommand* render_command = Clay_RenderCommandArray_Get(commands_array, i);
+		if (render_command->commandType != CLAY_RENDER_COMMAND_TYPE_SCISSOR_START) {
+			continue;
+		}
+
+		for (int j = 0; j < SCROLL_CACHES.count; j++) {
+			ScrollCache* cache = &SCROLL_CACHES.caches[j];
+			if (cache->id == render_command->id && cache->begin < 0) {
+				ScrollCache_resolve(cache, commands_array, i, w, h);
+				break;
+			}
+		}
+	}
+}
+
+static bool SDLCLAY_RecordsContain(const CommandRecord* records, const int count, const uint64_t hash) {
+	for (int i = 0; i < count; i++) {
+		if (records[i].hash == hash) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool SDLCLAY_RecordIntersects(const CommandRecord* record, const SDL_Rect rect) {
+	const SDL_FRect f_rect = {(float) rect.x, (float) rect.y, (float) rect.w, (float) rect.h};
+	return SDL_HasRectIntersectionFloat(&record->box, &f_rect);
+}
+
+/**
+ * Record the content commands of the frame relative to the content origin, and check them
+ * against those drawn in the part of the texture that is both valid and visible
+ *
+ * @return true if the valid area of the texture still matches the commands
+ */
+static bool ScrollCache_diff(ScrollCache* cache, Clay_RenderCommandArray* commands_array) {
+	const int count = cache->end - cache->begin;
+	for (int i = 0; i < count; i++) {
+		const Clay_RenderCommand* render_command = Clay_RenderCommandArray_Get(commands_array, cache->begin + i);
+		const Clay_BoundingBox box = render_command->boundingBox;
+		SCROLL_CACHES.current[i] = (CommandRecord){
+			Fingerprint_command(render_command, cache->origin),
+			{box.x - cache->origin.x, box.y - cache->origin.y, box.width, box.height}
+		};
+	}
+
+	SDL_Rect checked;
+	if (!SDL_GetRectIntersection(&cache->valid, &cache->visible, &checked)) {
+		return true;
+	}
+
+	for (int i = 0; i < count; i++) {
+		const CommandRecord* record = &SCROLL_CACHES.current[i];
+		if (SDLCLAY_RecordIntersects(record, checked) && !SDLCLAY_RecordsContain(cache->records, cache->record_count, record->hash)) {
+			return false;
+		}
+	}
+	for (int i = 0; i < cache->record_count; i++) {
+		const CommandRecord* record = &cache->records[i];
+		if (SDLCLAY_RecordIntersects(record, checked) && !SDLCLAY_RecordsContain(SCROLL_CACHES.current, count, record->hash)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Keep the records of the commands drawn so far: those of the frame for the visible
+ * area and the previous ones elsewhere in the valid area
+ */
+static void ScrollCache_store(ScrollCache* cache, const int count) {
+	int kept = 0;
+	for (int i = 0; i < cache->record_count; i++) {
+		if (!SDLCLAY_RecordIntersects(&cache->records[i], cache->visible) && SDLCLAY_RecordIntersects(&cache->records[i], cache->valid)) {
+			cache->records[kept++] = cache->records[i];
+		}
+	}
+	cache->record_count = kept;
+
+	for (int i = 0; i < count; i++) {
+		const CommandRecord* record = &SCROLL_CACHES.current[i];
+		if (!SDLCLAY_RecordIntersects(record, cache->visible)) {
+			continue;
+		}
+		if (!SDLCLAY_GrowBuffer((void**) &cache->records, &cache->record_capacity, cache->record_count + 1, sizeof(CommandRecord))) {
+			ScrollCache_reset(cache);
+			return;
+		}
+		cache->records[cache->record_count++] = *record;
+	}
+}
+
+/**
+ * @return Scroll cache whose content commands start at index and that can be blitted, NULL otherwise
+ */
+static ScrollCache* ScrollCaches_at(const int index) {
+	for (int i = 0; i < SCROLL_CACHES.count; i++) {
+		ScrollCache* cache = &SCROLL_CACHES.caches[i];
+		if (cache->begin == index && cache->texture != NULL) {
+			return cache;
+		}
+	}
+	return NULL;
+}
+
+void SDLCLAY_SetScrollCached(const Clay_ElementId element_id, const bool cached) {
+	for (int i = 0; i < SCROLL_CACHES.count; i++) {
+		ScrollCache* cache = &SCROLL_CACHES.caches[i];
+		if (cache->id != element_id.id) {
+			continue;
+		}
+
+		if (!cached) {
+			Layers_releaseTexture(cache->texture);
+			SDLCLAY_FREE(cache->records);
+			*cache = SCROLL_CACHES.caches[--SCROLL_CACHES.count];
+		}
+		return;
+	}
+
+	if (!cached) {
+		return;
+	}
+
+	if (SCROLL_CACHES.count == SDLCLAY_SCROLL_CACHE_MAX_COUNT) {
+		SDLCLAY_LOG("Cannot cache more than SDLCLAY_SCROLL_CACHE_MAX_COUNT (%d) scroll containers", SDLCLAY_SCROLL_CACHE_MAX_COUNT);
+		return;
+	}
+
+	SCROLL_CACHES.caches[SCROLL_CACHES.count++] = (ScrollCache){.id = element_id.id, .begin = -1};
+}
+
+static void ScrollCaches_free() {
+	for (int i = 0; i < SCROLL_CACHES.count; i++) {
+		if (SCROLL_CACHES.caches[i].texture != NULL) {
+			Layers_destroyTexture(SCROLL_CACHES.caches[i].texture);
+		}
+		SDLCLAY_FREE(SCROLL_CACHES.caches[i].records);
+	}
+	SDLCLAY_FREE(SCROLL_CACHES.current);
+	SDL_memset(&SCROLL_CACHES, 0, sizeof(SCROLL_CACHES));
+}
+
+// ===================================================================================
+// MARK: RENDER
+// ===================================================================================
+
+// ===================================================================================
+// MARK: Corners
+// ===================================================================================
+
+static struct CornerTables {
+	// Points of the unit quarter circle for each segment count, built on first use
+	SDL_FPoint points[SDLCLAY_NUM_SEGMENT_CORNER + 1][SDLCLAY_NUM_SEGMENT_CORNER + 1];
+	bool built[SDLCLAY_NUM_SEGMENT_CORNER + 1];
+} CORNER_TABLES = {0};
+
+static const SDL_FPoint* CornerTables_get(const int segments) {
+	if (!CORNER_TABLES.built[segments]) {
+		const float step = SDL_PI_F / 2.0f / (float) segments;
+		for (int i = 0; i <= segments; i++) {
+			const float angle = (float) i * step;
+			CORNER_TABLES.points[segments][i] = (SDL_FPoint){SDL_cosf(angle), SDL_sinf(angle)};
+		}
+		CORNER_TABLES.built[segments] = true;
+	}
+
+	return CORNER_TABLES.points[segments];
+}
+
+/**
+ * Smallest segment count keeping the on-screen distance between the arc
+ * and its chords under CORNER_TOLERANCE pixels. Commands are drawn unscaled,
+ * in pixels of the output, so the radius already is the on-screen one.
+ */
+static int CornerTables_segments(const float radius) {
+	if (radius <= CORNER_TOLERANCE) {
+		return 1;
+	}
+
+	// A chord spanning angle a is at most r * (1 - cos(a / 2)) away from the arc
+	const float max_angle = 2.0f * SDL_acosf(1.0f - CORNER_TOLERANCE / radius);
+	const int segments = (int) SDL_ceilf(SDL_PI_F / 2.0f / max_angle);
+
+	return SDL_clamp(segments, 1, SDLCLAY_NUM_SEGMENT_CORNER);
+}
+
+// ===================================================================================
+// MARK: Shapes
+// ===================================================================================
+
+static SDL_FColor SDLCLAY_ToFColor(const Clay_Color color) {
+	return (SDL_FColor){color.r / 255, color.g / 255, color.b / 255, color.a / 255};
+}
+
+static void SDLCLAY_RenderFillRect(
+	SDL_Renderer* renderer,
+	const SDL_FRect rect,
+	const Clay_Color color
+) {
+	if (rect.w <= 0 || rect.h <= 0) {
+		return;
+	}
+
+	if (GeometryBatch_reserve(renderer, NULL, 4, 6) >= 0) {
+		GeometryBatch_pushQuad(rect, (SDL_FRect){0, 0, 0, 0}, SDLCLAY_ToFColor(color));
+	}
+}
+
+// Corners in clockwise order, each arc going clockwise too
+typedef enum Corner {
+	CORNER_TOP_LEFT,
+	CORNER_TOP_RIGHT,
+	CORNER_BOTTOM_RIGHT,
+	CORNER_BOTTOM_LEFT,
+	CORNER_COUNT
+} Corner;
+
+/**
+ * Direction of the i-th point of a corner arc, from the unit quarter circle point (cos, sin)
+ */
+static SDL_FPoint SDLCLAY_CornerDirection(const Corner corner, const SDL_FPoint unit) {
+	switch (corner) {
+		case CORNER_TOP_LEFT: return (SDL_FPoint){-unit.x, -unit.y};
+		case CORNER_TOP_RIGHT: return (SDL_FPoint){unit.y, -unit.x};
+		case CORNER_BOTTOM_RIGHT: return (SDL_FPoint){unit.x, unit.y};
+		case CORNER_BOTTOM_LEFT: return (SDL_FPoint){-unit.y, unit.x};
+		default: return (SDL_FPoint){0, 0};
+	}
+}
+
+/**
+ * Clamp the radii of each corner so they fit in the rect
+ */
+static void SDLCLAY_ClampRadii(const SDL_FRect rect, const Clay_CornerRadius corner_radius, float radii[CORNER_COUNT]) {
+	const float max_radius = SDL_min(rect.w, rect.h) / 2.0f;
+	radii[CORNER_TOP_LEFT] = SDL_clamp(corner_radius.topLeft, 0.0f, max_radius);
+	radii[CORNER_TOP_RIGHT] = SDL_clamp(corner_radius.topRight, 0.0f, max_radius);
+	radii[CORNER_BOTTOM_RIGHT] = SDL_clamp(corner_radius.bottomRight, 0.0f, max_radius);
+	radii[CORNER_BOTTOM_LEFT] = SDL_clamp(corner_radius.bottomLeft, 0.0f, max_radius);
+}
+
+// ===================================================================================
+// MARK: Shape cache
+// ===================================================================================
+
+typedef enum ShapeKind {
+	SHAPE_KIND_FILL,
+	SHAPE_KIND_BORDER,
+} ShapeKind;
+
+/**
+ * Everything the tessellation of a shape depends on, its position and color excepted
+ */
+typedef struct ShapeKey {
+	int kind;
+	float w;
+	float h;
+	float radii[CORNER_COUNT];
+	// Border widths, left, right, top, bottom
+	float widths[4];
+	int segments[CORNER_COUNT];
+} ShapeKey;
+
+/**
+ * Tessellated shape relative to the top left of its rect, with indices relative to its first vertex
+ */
+typedef struct ShapeEntry {
+	ShapeKey key;
+	bool used;
+	SDL_FPoint* positions;
+	int* indices;
+	int vertex_count;
+	int index_count;
+	int vertex_capacity;
+	int index_capacity;
+} ShapeEntry;
+
+// Direct mapped, a shape replaces the one with the same slot
+static ShapeEntry SHAPE_CACHE[SDLCLAY_SHAPE_CACHE_SIZE] = {0};
+
+static bool ShapeEntry_reserve(ShapeEntry* entry, const int vertex_count, const int index_count) {
+	entry->vertex_count = vertex_count;
+	entry->index_count = index_count;
+	return SDLCLAY_GrowBuffer((void**) &entry->positions, &entry->vertex_capacity, vertex_count, sizeof(SDL_FPoint)) &&
+		SDLCLAY_GrowBuffer((void**) &entry->indices, &entry->index_capacity, index_count, sizeof(int));
+}
+
+/**
+ * Fill a rounded rect as a triangle fan around its center. The outline walks
+ * the four corner arcs clockwise, a square corner contributes a single point.
+ */
+static bool ShapeEntry_tessellateFill(ShapeEntry* entry) {
+	const ShapeKey* key = &entry->key;
+
+	int outline_count = 0;
+	for (int corner = 0; corner < CORNER_COUNT; corner++) {
+		outline_count += key->segments[corner] + 1;
+	}
+
+	if (!ShapeEntry_reserve(entry, outline_count + 1, outline_count * 3)) {
+		return false;
+	}
+
+	SDL_FPoint* positions = entry->positions;
+	int* indices = entry->indices;
+	int vertex_count = 0, index_count = 0;
+
+	// [0] Center of the fan
+	positions[vertex_count++] = (SDL_FPoint){key->w / 2, key->h / 2};
+
+	const float* radii = key->radii;
+	const SDL_FPoint centers[CORNER_COUNT] = {
+		{radii[CORNER_TOP_LEFT], radii[CORNER_TOP_LEFT]},
+		{key->w - radii[CORNER_TOP_RIGHT], radii[CORNER_TOP_RIGHT]},
+		{key->w - radii[CORNER_BOTTOM_RIGHT], key->h - radii[CORNER_BOTTOM_RIGHT]},
+		{radii[CORNER_BOTTOM_LEFT], key->h - radii[CORNER_BOTTOM_LEFT]},
+	};
+
+	for (int corner = 0; corner < CORNER_COUNT; corner++) {
+		const SDL_FPoint* unit_circle = CornerTables_get(SDL_max(key->segments[corner], 1));
+		for (int i = 0; i <= key->segments[corner]; i++) {
+			const SDL_FPoint direction = SDLCLAY_CornerDirection((Corner) corner, unit_circle[i]);
+			positions[vertex_count++] = (SDL_FPoint){
+				centers[corner].x + direction.x * radii[corner],
+				centers[corner].y + direction.y * radii[corner]
+			};
+		}
+	}
+
+	for (int i = 0; i < outline_count; i++) {
+		indices[index_count++] = 0;
+		indices[index_count++] = 1 + i;
+		indices[index_count++] = 1 + (i + 1) % outline_count;
+	}
+
+	return true;
+}
+
+/**
+ * Draw a border as the ring between the outer rounded rect and the inner one.
+ * Each side has its own width and each corner its own radius, inner corners
+ * are elliptical when the two adjacent sides differ, like CSS borders.
+ */
+static bool ShapeEntry_tessellateBorder(ShapeEntry* entry) {
+	const ShapeKey* key = &entry->key;
+
+	int outline_count = 0;
+	for (int corner = 0; corner < CORNER_COUNT; corner++) {
+		outline_count += key->segments[corner] + 1;
+	}
+
+	if (!ShapeEntry_reserve(entry, outline_count * 2, outline_count * 6)) {
+		return false;
+	}
+
+	SDL_FPoint* positions = entry->positions;
+	int* indices = entry->indices;
+	int vertex_count = 0, index_count = 0;
+
+	const float left = key->widths[0];
+	const float right = key->widths[1];
+	const float top = key->widths[2];
+	const float bottom = key->widths[3];
+
+	// Widths of the sides meeting at each corner, horizontal then vertical
+	const SDL_FPoint corner_widths[CORNER_COUNT] = {
+		{left, top},
+		{right, top},
+		{right, bottom},
+		{left, bottom},
+	};
+	// Direction from the rect corner toward its inside
+	const SDL_FPoint inward[CORNER_COUNT] = {
+		{1, 1},
+		{-1, 1},
+		{-1, -1},
+		{1, -1},
+	};
+	const SDL_FPoint rect_corners[CORNER_COUNT] = {
+		{0, 0},
+		{key->w, 0},
+		{key->w, key->h},
+		{0, key->h},
+	};
+
+	for (int corner = 0; corner < CORNER_COUNT; corner++) {
+		const float radius = key->radii[corner];
+		const SDL_FPoint widths = corner_widths[corner];
+		const SDL_FPoint inner_radius = {SDL_max(radius - widths.x, 0.0f), SDL_max(radius - widths.y, 0.0f)};
+
+		const SDL_FPoint outer_center = {
+			rect_corners[corner].x + inward[corner].x * radius,
+			rect_corners[corner].y + inward[corner].y * radius
+		};
+		const SDL_FPoint inner_center = {
+			rect_corners[corner].x + inward[corner].x * (widths.x + inner_radius.x),
+			rect_corners[corner].y + inward[corner].y * (widths.y + inner_radius.y)
+		};
+
+		const SDL_FPoint* unit_circle = CornerTables_get(SDL_max(key->segments[corner], 1));
+		for (int i = 0; i <= key->segments[corner]; i++) {
+			const SDL_FPoint direction = SDLCLAY_CornerDirection((Corner) corner, unit_circle[i]);
+			// [2 * n] Outer point, [2 * n + 1] Inner point
+			positions[vertex_count++] = (SDL_FPoint){
+				outer_center.x + direction.x * radius,
+				outer_center.y + direction.y * radius
+			};
+			positions[vertex_count++] = (SDL_FPoint){
+				inner_center.x + direction.x * inner_radius.x,
+				inner_center.y + direction.y * inner_radius.y
+			};
+		}
+	}
+
+	for (int i = 0; i < outline_count; i++) {
+		const int outer = 2 * i;
+		const int next_outer = 2 * ((i + 1) % outline_count);
+
+		indices[index_count++] = outer;
+		indices[index_count++] = next_outer;
+		indices[index_count++] = next_outer + 1;
+		indices[index_count++] = outer;
+		indices[index_count++] = next_outer + 1;
+		indices[index_count++] = outer + 1;
+	}
+
+	return true;
+}
+
+/**
+ * Get the tessellation of a shape, built on a miss
+ * @return Cached shape or NULL on allocation failure
+ */
+static const ShapeEntry* ShapeCache_get(const ShapeKey* key) {
+	const uint64_t hash = SDLCLAY_HashContinue(SDLCLAY_HASH_INIT, key, sizeof(ShapeKey));
+	ShapeEntry* entry = &SHAPE_CACHE[hash % SDLCLAY_SHAPE_CACHE_SIZE];
+
+	if (entry->used && SDL_memcmp(&entry->key, key, sizeof(ShapeKey)) == 0) {
+		STATS.shape_cache_hits++;
+		return entry;
+	}
+
+	STATS.shape_cache_misses++;
+	entry->key = *key;
+	entry->used = key->kind == SHAPE_KIND_FILL ? ShapeEntry_tessellateFill(entry) : ShapeEntry_tessellateBorder(entry);
+
+	return entry->used ? entry : NULL;
+}
+
+/**
+ * Append a cached shape moved to origin and colored
+ */
+static void ShapeCache_draw(SDL_Renderer* renderer, const ShapeEntry* entry, const SDL_FPoint origin, const SDL_FColor color) {
+	if (GeometryBatch_reserve(renderer, NULL, entry->vertex_count, entry->index_count) < 0) {
+		return;
+	}
+
+	SDL_Vertex* vertices = GeometryBatch_vertices();
+	for (int i = 0; i < entry->vertex_count; i++) {
+		vertices[i] = (SDL_Vertex){{origin.x + entry->positions[i].x, origin.y + entry->positions[i].y}, color, {0, 0}};
+	}
+	SDL_memcpy(GeometryBatch_indices(), entry->indices, (size_t) entry->index_count * sizeof(int));
+
+	GeometryBatch_commit(entry->vertex_count, entry->index_count);
+}
+
+static void ShapeCache_free() {
+	for (int i = 0; i < SDLCLAY_SHAPE_CACHE_SIZE; i++) {
+		SDLCLAY_FREE(SHAPE_CACHE[i].positions);
+		SDLCLAY_FREE(SHAPE_CACHE[i].indices);
+	}
+	SDL_memset(SHAPE_CACHE, 0, sizeof(SHAPE_CACHE));
+}
+
 // ===================================================================================
-// MARK: FONTS
+// MARK: Corner stamps
 // ===================================================================================
 
-typedef struct Font {
-	TTF_Font* ttf_fonts[SDLCLAY_FONT_MAX_SIZE];
-	int init_size;
-} Font;
+/**
+ * Anti-aliased top left corner of radius pixels, a quarter disk for fills
+ * or a quarter ring for borders of widths width_x and width_y
+ */
+typedef struct Stamp {
+	int radius;
+	int width_x;
+	int width_y;
+	bool fill;
+	SDL_Rect src;
+} Stamp;
 
-static struct FontsHolder {
-	Font* fonts;
-	int count;
-	struct FontsHolder* next;
-	int deepness;
-} FONTS_HOLDER = {0};
-
-static void FontHolder_init(struct FontsHolder * font_holder, const int deepness) {
-	const size_t size = SDLCLAY_FONT_HOLDER_CAPACITY * sizeof(Font);
-	font_holder->fonts = SDLCLAY_MALLOC(size);
-	SDL_memset(font_holder->fonts, 0, size);
-	font_holder->count = 0;
-	font_holder->next = NULL;
-	font_holder->deepness = deepness;
-}
-
-static void FontHolder_free(struct FontsHolder * font_holder) {
-	struct FontsHolder* current = font_holder;
-	do {
-		struct FontsHolder* next = current->next;
-		SDLCLAY_FREE(current->fonts);
-		if (current->deepness != 0) {
-			SDLCLAY_FREE(current);
-		}
-		current = next;
-	} while (current != NULL);
-}
-
-int SDLCLAY_AddFont(const char * font_path, const int init_size) {
-	if (font_path == NULL || init_size >= SDLCLAY_FONT_MAX_SIZE) {
-		SDLCLAY_LOG("Invalid font path:\"%s\" or size: %d", font_path, init_size);
-		return -1;
+static struct StampAtlas {
+	SDL_Renderer* renderer;
+	AtlasPage page;
+	// White pixels used by the straight parts, so a whole shape is one batch
+	SDL_Rect white;
+	Stamp stamps[SDLCLAY_STAMP_MAX_COUNT];
+	int stamp_count;
+	// Incremented when the atlas is recycled, invalidating the stamps
+	int generation;
+} STAMP_ATLAS = {0};
+
+static void StampAtlas_free() {
+	if (STAMP_ATLAS.page.texture != NULL) {
+		SDL_DestroyTexture(STAMP_ATLAS.page.texture);
 	}
+	SDL_memset(&STAMP_ATLAS, 0, sizeof(STAMP_ATLAS));
+}
 
-	TTF_Font* font = TTF_OpenFont(font_path, (float) init_size);
+/**
+ * Upload a w*h area of white pixels with the given 8 bits coverage, NULL for opaque
+ */
+static bool StampAtlas_upload(const SDL_Rect rect, const uint8_t* coverage) {
+	uint32_t* pixels = SDLCLAY_MALLOC((size_t) rect.w * (size_t) rect.h * sizeof(uint32_t));
+	if (pixels == NULL) {
+		return false;
+	}
 
-	if (font == NULL) {
-		SDLCLAY_LOG("Failed to load font: %s, %s", font_path, SDL_GetError());
-		return -1;
+	for (int i = 0; i < rect.w * rect.h; i++) {
+		const uint32_t alpha = coverage != NULL ? coverage[i] : 255;
+		pixels[i] = alpha << 24 | 0x00FFFFFFu;
 	}
 
-	return SDLCLAY_AddFontRaw(font, init_size);
+	const bool updated = SDL_UpdateTexture(STAMP_ATLAS.page.texture, &rect, pixels, rect.w * (int) sizeof(uint32_t));
+	SDLCLAY_FREE(pixels);
+	return updated;
 }
 
-int SDLCLAY_AddFontRaw(TTF_Font * font, const int init_size) {
-	if (font == NULL || init_size >= SDLCLAY_FONT_MAX_SIZE) {
-		SDLCLAY_LOG("Invalid font %p or size: %d", font, init_size);
-		return -1;
+/**
+ * Reset the atlas, creating its page on first use
+ */
+static bool StampAtlas_reset(SDL_Renderer* renderer) {
+	if (STAMP_ATLAS.renderer != renderer) {
+		StampAtlas_free();
 	}
 
-	if (FONTS_HOLDER.fonts == NULL) {
-		FontHolder_init(&FONTS_HOLDER, 0);
+	if (STAMP_ATLAS.page.texture == NULL) {
+		SDL_Texture* texture = SDL_CreateTexture(
+			renderer,
+			SDL_PIXELFORMAT_ARGB8888,
+			SDL_TEXTUREACCESS_STATIC,
+			SDLCLAY_STAMP_ATLAS_PAGE_SIZE,
+			SDLCLAY_STAMP_ATLAS_PAGE_SIZE
+		);
+		if (texture == NULL) {
+			SDLCLAY_LOG("Failed to create corner stamp atlas: %s", SDL_GetError());
+			return false;
+		}
+		SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+		SDL_SetTextureScaleMode(texture, SDL_SCALEMODE_NEAREST);
+		STAMP_ATLAS.renderer = renderer;
+		STAMP_ATLAS.page.texture = texture;
+		STAMP_ATLAS.page.size = SDLCLAY_STAMP_ATLAS_PAGE_SIZE;
 	}
 
-	struct FontsHolder* current = &FONTS_HOLDER;
-	while (current->count >= SDLCLAY_FONT_HOLDER_CAPACITY) {
-		if (current->next == NULL) {
-			struct FontsHolder* new = SDLCLAY_MALLOC(sizeof(struct FontsHolder));
-			FontHolder_init(new, current->deepness + 1);
-			current->next = new;
+	STAMP_ATLAS.page.shelf_x = 0;
+	STAMP_ATLAS.page.shelf_y = 0;
+	STAMP_ATLAS.page.shelf_height = 0;
+	STAMP_ATLAS.stamp_count = 0;
+	STAMP_ATLAS.generation++;
+
+	// Sampled at its center, the border keeps neighbours out of reach
+	return AtlasPage_pack(&STAMP_ATLAS.page, 3, 3, &STAMP_ATLAS.white) && StampAtlas_upload(STAMP_ATLAS.white, NULL);
+}
+
+/**
+ * Coverage of the stamp pixels, sampled 4x4 per pixel. The corner is at (0, 0)
+ * and the arc centered on (radius, radius).
+ */
+static void Stamp_rasterize(const Stamp* stamp, uint8_t* coverage) {
+	const float radius = (float) stamp->radius;
+	const float inner_x = radius - (float) stamp->width_x;
+	const float inner_y = radius - (float) stamp->width_y;
+	const bool has_inner = !stamp->fill && inner_x > 0 && inner_y > 0;
+
+	for (int y = 0; y < stamp->radius; y++) {
+		for (int x = 0; x < stamp->radius; x++) {
+			int samples = 0;
+			for (int sy = 0; sy < 4; sy++) {
+				for (int sx = 0; sx < 4; sx++) {
+					const float dx = (float) x + ((float) sx + 0.5f) / 4.0f - radius;
+					const float dy = (float) y + ((float) sy + 0.5f) / 4.0f - radius;
+					const bool outer = dx * dx + dy * dy <= radius * radius;
+					const bool inner = has_inner && (dx * dx) / (inner_x * inner_x) + (dy * dy) / (inner_y * inner_y) < 1.0f;
+					samples += outer && !inner;
+				}
+			}
+			coverage[y * stamp->radius + x] = (uint8_t) (samples * 255 / 16);
 		}
-		current = current->next;
 	}
+}
 
-	current->fonts[current->count].ttf_fonts[init_size] = font;
-	current->fonts[current->count].init_size = init_size;
-	current->count++;
+static const Stamp* StampAtlas_get(SDL_Renderer* renderer, const int radius, const int width_x, const int width_y, const bool fill) {
+	if (STAMP_ATLAS.renderer != renderer || STAMP_ATLAS.page.texture == NULL) {
+		if (!StampAtlas_reset(renderer)) {
+			return NULL;
+		}
+	}
 
-	return current->deepness * SDLCLAY_FONT_HOLDER_CAPACITY + current->count - 1;
-}
+	for (int i = 0; i < STAMP_ATLAS.stamp_count; i++) {
+		const Stamp* stamp = &STAMP_ATLAS.stamps[i];
+		if (stamp->radius == radius && stamp->width_x == width_x && stamp->width_y == width_y && stamp->fill == fill) {
+			return stamp;
+		}
+	}
 
-TTF_Font* SDLCLAY_GetFont(const int font_index, const int size) {
-	const struct FontsHolder* current = &FONTS_HOLDER;
-	const int deepness = font_index / SDLCLAY_FONT_HOLDER_CAPACITY;
-	const int index = font_index % SDLCLAY_FONT_HOLDER_CAPACITY;
-	for (int i = 0; i < deepness; i++) {
-		current = current->next;
+	Stamp stamp = {radius, width_x, width_y, fill, {0}};
+	if (STAMP_ATLAS.stamp_count == SDLCLAY_STAMP_MAX_COUNT || !AtlasPage_pack(&STAMP_ATLAS.page, radius, radius, &stamp.src)) {
+		// Every stamp drawn so far must reach the screen before the page is rewritten
+		GeometryBatch_flush(renderer);
+		if (!StampAtlas_reset(renderer) || !AtlasPage_pack(&STAMP_ATLAS.page, radius, radius, &stamp.src)) {
+			return NULL;
+		}
 	}
-	Font* font = &current->fonts[index];
 
-	if (font->ttf_fonts[size] == NULL) {
-		font->ttf_fonts[size] = TTF_CopyFont(font->ttf_fonts[font->init_size]);
-		TTF_SetFontSize(font->ttf_fonts[size], (float)size);
+	uint8_t* coverage = SDLCLAY_MALLOC((size_t) radius * (size_t) radius);
+	if (coverage == NULL) {
+		return NULL;
+	}
+	Stamp_rasterize(&stamp, coverage);
+	const bool uploaded = StampAtlas_upload(stamp.src, coverage);
+	SDLCLAY_FREE(coverage);
+	if (!uploaded) {
+		return NULL;
 	}
 
-	return font->ttf_fonts[size];
+	STATS.stamp_rasterizations++;
+	STAMP_ATLAS.stamps[STAMP_ATLAS.stamp_count] = stamp;
+	return &STAMP_ATLAS.stamps[STAMP_ATLAS.stamp_count++];
 }
 
-Clay_Dimensions SDLCLAY_MeasureText(
-	Clay_StringSlice text,
-	Clay_TextElementConfig* config,
-	void* userData
+/**
+ * Get the stamps of the four corners, retried when the atlas is recycled in between
+ * @return false if a stamp cannot be made, the shape should be tessellated instead
+ */
+static bool StampAtlas_getCorners(
+	SDL_Renderer* renderer,
+	const int radii[CORNER_COUNT],
+	const SDL_Point widths[CORNER_COUNT],
+	const bool fill,
+	const Stamp* stamps[CORNER_COUNT]
 ) {
-	TTF_Font* font = SDLCLAY_GetFont(config->fontId, config->fontSize);
-	const int height = TTF_GetFontHeight(font);
-	int width = 0;
-
-	TTF_MeasureString(font, text.chars, text.length, 0, &width, NULL);
-
-	const Clay_Dimensions result = {
-		.height = (float) height,
-		.width = (float) width,
-	};
+	for (int attempt = 0; attempt < 2; attempt++) {
+		const int generation = STAMP_ATLAS.generation;
+		bool complete = true;
+		for (int corner = 0; corner < CORNER_COUNT && complete; corner++) {
+			stamps[corner] = NULL;
+			if (radii[corner] > 0) {
+				stamps[corner] = StampAtlas_get(renderer, radii[corner], widths[corner].x, widths[corner].y, fill);
+				complete = stamps[corner] != NULL;
+			}
+		}
 
-	return result;
+		if (!complete) {
+			return false;
+		}
+		if (generation == STAMP_ATLAS.generation) {
+			return true;
+		}
+	}
+	return false;
 }
 
-// ===================================================================================
-// MARK: RENDER
-// ===================================================================================
-
-static void SDLCLAY_SetRenderDrawColor(SDL_Renderer* renderer, const Clay_Color color) {
-	SDL_SetRenderDrawColor(renderer, (int) color.r, (int) color.g, (int) color.b, (int) color.a);
+static SDL_FRect StampAtlas_uv(const SDL_Rect src) {
+	const float size = (float) STAMP_ATLAS.page.size;
+	return (SDL_FRect){(float) src.x / size, (float) src.y / size, (float) src.w / size, (float) src.h / size};
 }
 
-static void SDLCLAY_RenderFillRoundedRect(
-	SDL_Renderer* renderer,
-	const SDL_FRect rect,
-	const float corner_radius,
-	const Clay_Color clay_color
-) {
-	const SDL_FColor color = {clay_color.r / 255, clay_color.g / 255, clay_color.b / 255, clay_color.a / 255};
+static void StampAtlas_pushQuad(SDL_Renderer* renderer, const SDL_FRect dst, const SDL_FRect uv, const SDL_FColor color) {
+	if (dst.w > 0 && dst.h > 0 && GeometryBatch_reserve(renderer, STAMP_ATLAS.page.texture, 4, 6) >= 0) {
+		GeometryBatch_pushQuad(dst, uv, color);
+	}
+}
 
-	int index_count = 0, vertex_count = 0;
+static void StampAtlas_pushSolid(SDL_Renderer* renderer, const SDL_FRect dst, const SDL_FColor color) {
+	const float size = (float) STAMP_ATLAS.page.size;
+	const SDL_FRect uv = {((float) STAMP_ATLAS.white.x + 1.5f) / size, ((float) STAMP_ATLAS.white.y + 1.5f) / size, 0, 0};
+	StampAtlas_pushQuad(renderer, dst, uv, color);
+}
 
-	const float min_radius = SDL_min(rect.w, rect.h) / 2.0f;
-	const float clamp_radius = SDL_min(corner_radius, min_radius);
+/**
+ * Draw the stamp of a corner, mirrored from the top left one
+ */
+static void StampAtlas_pushCorner(SDL_Renderer* renderer, const SDL_FRect rect, const Corner corner, const Stamp* stamp, const SDL_FColor color) {
+	const float size = (float) stamp->radius;
+	SDL_FRect uv = StampAtlas_uv(stamp->src);
+	SDL_FRect dst = {rect.x, rect.y, size, size};
 
-	const int num_circle_segments = SDL_max(SDLCLAY_NUM_SEGMENT_CORNER, (int) clamp_radius * 0.5f);
-	const int total_vertices = 4 + 4 * (num_circle_segments * 2) + 2 * 4;
-	const int total_indices = 6 + 4 * (num_circle_segments * 3) + 6 * 4;
+	if (corner == CORNER_TOP_RIGHT || corner == CORNER_BOTTOM_RIGHT) {
+		dst.x = rect.x + rect.w - size;
+		uv.x += uv.w;
+		uv.w = -uv.w;
+	}
+	if (corner == CORNER_BOTTOM_RIGHT || corner == CORNER_BOTTOM_LEFT) {
+		dst.y = rect.y + rect.h - size;
+		uv.y += uv.h;
+		uv.h = -uv.h;
+	}
 
-	SDL_Vertex vertices[total_vertices];
-	int indices[total_indices];
+	StampAtlas_pushQuad(renderer, dst, uv, color);
+}
 
-	// ==================================
-	// Define center rectangle
-	// ==================================
+/**
+ * Radii of the stamps, whole pixels that still fit in the rect
+ */
+static void SDLCLAY_StampRadii(const SDL_FRect rect, const Clay_CornerRadius corner_radius, int radii[CORNER_COUNT]) {
+	float clamped[CORNER_COUNT];
+	SDLCLAY_ClampRadii(rect, corner_radius, clamped);
 
-	// [0] Center Top Left
-	vertices[vertex_count++] = (SDL_Vertex){
-		{
-			rect.x + clamp_radius,
-			rect.y + clamp_radius
-		},
-		color,
-		{0, 0}
-	};
-	// [1] Center Top Right
-	vertices[vertex_count++] = (SDL_Vertex){
-		{
-			rect.x + rect.w - clamp_radius,
-			rect.y + clamp_radius
-		},
-		color,
-		{1, 0}
-	};
-	// [2] Center Bottom Right
-	vertices[vertex_count++] = (SDL_Vertex){
-		{
-			rect.x + rect.w - clamp_radius,
-			rect.y + rect.h - clamp_radius
-		},
-		color,
-		{1, 1}
-	};
-	// [3] Center Bottom Left
-	vertices[vertex_count++] = (SDL_Vertex){
-		{
-			rect.x + clamp_radius,
-			rect.y + rect.h - clamp_radius
-		},
-		color,
-		{0, 1}
-	};
+	const int max_radius = (int) SDL_floorf(SDL_min(rect.w, rect.h) / 2.0f);
+	for (int corner = 0; corner < CORNER_COUNT; corner++) {
+		radii[corner] = SDL_min((int) SDL_roundf(clamped[corner]), max_radius);
+	}
+}
 
-	indices[index_count++] = 0;
-	indices[index_count++] = 1;
-	indices[index_count++] = 3;
-	indices[index_count++] = 1;
-	indices[index_count++] = 2;
-	indices[index_count++] = 3;
-
-	// ==================================
-	// Define rounded corners as triangle fans
-	// ==================================
-
-	const float step = SDL_PI_F / 2.0f / (float) num_circle_segments;
-
-	for (int i = 0; i < num_circle_segments; i++) {
-
-		const float angle1 = (float) i * step;
-		const float angle2 = (float) (i + 1) * step;
-
-		// Iterate over four corners
-		for (int j = 0; j < 4; j++) {
-			float cx, cy, sign_x, sign_y;
-
-			switch (j) {
-				case 0: // Top-left
-					cx = rect.x + clamp_radius;
-					cy = rect.y + clamp_radius;
-					sign_x = -1;
-					sign_y = -1;
-					break;
-
-				case 1: // Top-right
-					cx = rect.x + rect.w - clamp_radius;
-					cy = rect.y + clamp_radius;
-					sign_x = 1;
-					sign_y = -1;
-					break;
-				case 2: // Bottom-right
-					cx = rect.x + rect.w - clamp_radius;
-					cy = rect.y + rect.h - clamp_radius;
-					sign_x = 1;
-					sign_y = 1;
-					break;
-				case 3: // Bottom-left
-					cx = rect.x + clamp_radius;
-					cy = rect.y + rect.h - clamp_radius;
-					sign_x = -1;
-					sign_y = 1;
-					break;
-				default:
-					break;
-			}
-
-			vertices[vertex_count++] = (SDL_Vertex){
-				{
-					cx + SDL_cosf(angle1) * clamp_radius * sign_x,
-					cy + SDL_sinf(angle1) * clamp_radius * sign_y
-				},
-				color,
-				{0, 0}
-			};
+/**
+ * Fill a rounded rect with corner stamps and at most seven solid quads:
+ * the top band between the top corners, the bottom one and the middle
+ *
+ * @return false if stamps are not available and the shape should be tessellated
+ */
+static bool StampAtlas_drawFill(SDL_Renderer* renderer, const SDL_FRect rect, const Clay_CornerRadius corner_radius, const SDL_FColor color) {
+	int r[CORNER_COUNT];
+	SDLCLAY_StampRadii(rect, corner_radius, r);
+	if (r[CORNER_TOP_LEFT] > SDLCLAY_STAMP_MAX_RADIUS || r[CORNER_TOP_RIGHT] > SDLCLAY_STAMP_MAX_RADIUS ||
+		r[CORNER_BOTTOM_RIGHT] > SDLCLAY_STAMP_MAX_RADIUS || r[CORNER_BOTTOM_LEFT] > SDLCLAY_STAMP_MAX_RADIUS) {
+		return false;
+	}
 
-			vertices[vertex_count++] = (SDL_Vertex){
-				{
-					cx + SDL_cosf(angle2) * clamp_radius * sign_x,
-					cy + SDL_sinf(angle2) * clamp_radius * sign_y
-				},
-				color,
-				{0, 0}
-			};
+	const SDL_Point no_widths[CORNER_COUNT] = {0};
+	const Stamp* stamps[CORNER_COUNT];
+	if (!StampAtlas_getCorners(renderer, r, no_widths, true, stamps)) {
+		return false;
+	}
 
-			// Connect to corresponding central rectangle vertex
-			indices[index_count++] = j;
-			indices[index_count++] = vertex_count - 2;
-			indices[index_count++] = vertex_count - 1;
+	for (int corner = 0; corner < CORNER_COUNT; corner++) {
+		if (stamps[corner] != NULL) {
+			StampAtlas_pushCorner(renderer, rect, (Corner) corner, stamps[corner], color);
 		}
 	}
 
-	// ==================================
-	// Define edges rectangles
-	// ==================================
+	const float tl = (float) r[CORNER_TOP_LEFT], tr = (float) r[CORNER_TOP_RIGHT];
+	const float br = (float) r[CORNER_BOTTOM_RIGHT], bl = (float) r[CORNER_BOTTOM_LEFT];
+	const float top = SDL_max(tl, tr);
+	const float bottom = SDL_max(bl, br);
 
-	// ==================================
-	// Top
-	// ==================================
-	// Top Left
-	vertices[vertex_count++] = (SDL_Vertex){
-		{
-			rect.x + clamp_radius,
-			rect.y
-		},
-		color,
-		{0, 0}
-	};
-	// Top Right
-	vertices[vertex_count++] = (SDL_Vertex){
-		{
-			rect.x + rect.w - clamp_radius,
-			rect.y
-		},
-		color,
-		{1, 0}
-	};
+	// Top band, with the space below the smaller corner
+	StampAtlas_pushSolid(renderer, (SDL_FRect){rect.x + tl, rect.y, rect.w - tl - tr, top}, color);
+	StampAtlas_pushSolid(renderer, (SDL_FRect){rect.x, rect.y + tl, tl, top - tl}, color);
+	StampAtlas_pushSolid(renderer, (SDL_FRect){rect.x + rect.w - tr, rect.y + tr, tr, top - tr}, color);
+	// Bottom band, with the space above the smaller corner
+	StampAtlas_pushSolid(renderer, (SDL_FRect){rect.x + bl, rect.y + rect.h - bottom, rect.w - bl - br, bottom}, color);
+	StampAtlas_pushSolid(renderer, (SDL_FRect){rect.x, rect.y + rect.h - bottom, bl, bottom - bl}, color);
+	StampAtlas_pushSolid(renderer, (SDL_FRect){rect.x + rect.w - br, rect.y + rect.h - bottom, br, bottom - br}, color);
+	// Middle
+	StampAtlas_pushSolid(renderer, (SDL_FRect){rect.x, rect.y + top, rect.w, rect.h - top - bottom}, color);
 
-	indices[index_count++] = 0;
-	indices[index_count++] = vertex_count - 2; //TL
-	indices[index_count++] = vertex_count - 1; //TR
-	indices[index_count++] = 1;
-	indices[index_count++] = 0;
-	indices[index_count++] = vertex_count - 1; //TR
-
-	// ==================================
-	// Right
-	// ==================================
-	// Right Top
-	vertices[vertex_count++] = (SDL_Vertex){
-		{
-			rect.x + rect.w,
-			rect.y + clamp_radius
-		},
-		color,
-		{1, 0}
-	};
-	// Right Bottom
-	vertices[vertex_count++] = (SDL_Vertex){
-		{
-			rect.x + rect.w,
-			rect.y + rect.h - clamp_radius
-		},
-		color,
-		{1, 1}
-	};
+	return true;
+}
 
-	indices[index_count++] = 1;
-	indices[index_count++] = vertex_count - 2; //RT
-	indices[index_count++] = vertex_count - 1; //RB
-	indices[index_count++] = 2;
-	indices[index_count++] = 1;
-	indices[index_count++] = vertex_count - 1; //RB
-
-	// ==================================
-	// Bottom
-	// ==================================
-	// Bottom Right
-	vertices[vertex_count++] = (SDL_Vertex){
-		{
-			rect.x + rect.w - clamp_radius,
-			rect.y + rect.h
-		},
-		color,
-		{1, 1}
-	};
-	// Bottom Left
-	vertices[vertex_count++] = (SDL_Vertex){
-		{
-			rect.x + clamp_radius,
-			rect.y + rect.h
-		},
-		color,
-		{0, 1}
-	};
+/**
+ * Draw a border with ring stamps for the rounded corners and solid quads for the sides
+ *
+ * @param widths Left, right, top and bottom widths
+ * @return false if stamps are not available and the shape should be tessellated
+ */
+static bool StampAtlas_drawBorder(
+	SDL_Renderer* renderer,
+	const SDL_FRect rect,
+	const Clay_CornerRadius corner_radius,
+	const float widths[4],
+	const SDL_FColor color
+) {
+	int r[CORNER_COUNT];
+	SDLCLAY_StampRadii(rect, corner_radius, r);
 
-	indices[index_count++] = 2;
-	indices[index_count++] = vertex_count - 2; //BR
-	indices[index_count++] = vertex_count - 1; //BL
-	indices[index_count++] = 3;
-	indices[index_count++] = 2;
-	indices[index_count++] = vertex_count - 1; //BL
-
-	// ==================================
-	// Left
-	// ==================================
-	// Left Bottom
-	vertices[vertex_count++] = (SDL_Vertex){
-		{
-			rect.x,
-			rect.y + rect.h - clamp_radius
-		},
-		color,
-		{0, 1}
-	};
-	// Left Top
-	vertices[vertex_count++] = (SDL_Vertex){
-		{
-			rect.x,
-			rect.y + clamp_radius
-		},
-		color,
-		{0, 0}
+	const int left = (int) SDL_roundf(widths[0]), right = (int) SDL_roundf(widths[1]);
+	const int top = (int) SDL_roundf(widths[2]), bottom = (int) SDL_roundf(widths[3]);
+	const SDL_Point corner_widths[CORNER_COUNT] = {
+		{left, top},
+		{right, top},
+		{right, bottom},
+		{left, bottom},
 	};
 
-	indices[index_count++] = 3;
-	indices[index_count++] = vertex_count - 2; //LB
-	indices[index_count++] = vertex_count - 1; //LT
-	indices[index_count++] = 0;
-	indices[index_count++] = 3;
-	indices[index_count++] = vertex_count - 1; //LT
+	// Rounded corners thinner than the border are left to the tessellation
+	SDL_FPoint boxes[CORNER_COUNT];
+	for (int corner = 0; corner < CORNER_COUNT; corner++) {
+		if (r[corner] > SDLCLAY_STAMP_MAX_RADIUS || (r[corner] > 0 && (r[corner] < corner_widths[corner].x || r[corner] < corner_widths[corner].y))) {
+			return false;
+		}
+		boxes[corner] = r[corner] > 0
+			? (SDL_FPoint){(float) r[corner], (float) r[corner]}
+			: (SDL_FPoint){(float) corner_widths[corner].x, (float) corner_widths[corner].y};
+	}
+
+	const Stamp* stamps[CORNER_COUNT];
+	if (!StampAtlas_getCorners(renderer, r, corner_widths, false, stamps)) {
+		return false;
+	}
 
-	// ==================================
-	// Draw
-	// ==================================
+	for (int corner = 0; corner < CORNER_COUNT; corner++) {
+		if (stamps[corner] != NULL) {
+			StampAtlas_pushCorner(renderer, rect, (Corner) corner, stamps[corner], color);
+		}
+	}
 
-	// TODO: Temp fix, Find why this is needed and it still look bad
-	for (int i = 0; i < vertex_count; i++) {
-		if (vertices[i].position.y > rect.h) vertices[i].position.y -= 1;
+	// Square corners
+	if (r[CORNER_TOP_LEFT] == 0) {
+		StampAtlas_pushSolid(renderer, (SDL_FRect){rect.x, rect.y, boxes[CORNER_TOP_LEFT].x, boxes[CORNER_TOP_LEFT].y}, color);
 	}
+	if (r[CORNER_TOP_RIGHT] == 0) {
+		StampAtlas_pushSolid(renderer, (SDL_FRect){rect.x + rect.w - boxes[CORNER_TOP_RIGHT].x, rect.y, boxes[CORNER_TOP_RIGHT].x, boxes[CORNER_TOP_RIGHT].y}, color);
+	}
+	if (r[CORNER_BOTTOM_RIGHT] == 0) {
+		StampAtlas_pushSolid(renderer, (SDL_FRect){rect.x + rect.w - boxes[CORNER_BOTTOM_RIGHT].x, rect.y + rect.h - boxes[CORNER_BOTTOM_RIGHT].y, boxes[CORNER_BOTTOM_RIGHT].x, boxes[CORNER_BOTTOM_RIGHT].y}, color);
+	}
+	if (r[CORNER_BOTTOM_LEFT] == 0) {
+		StampAtlas_pushSolid(renderer, (SDL_FRect){rect.x, rect.y + rect.h - boxes[CORNER_BOTTOM_LEFT].y, boxes[CORNER_BOTTOM_LEFT].x, boxes[CORNER_BOTTOM_LEFT].y}, color);
+	}
+
+	// Sides between the corners
+	const float tl_x = boxes[CORNER_TOP_LEFT].x, tl_y = boxes[CORNER_TOP_LEFT].y;
+	const float tr_x = boxes[CORNER_TOP_RIGHT].x, tr_y = boxes[CORNER_TOP_RIGHT].y;
+	const float br_x = boxes[CORNER_BOTTOM_RIGHT].x, br_y = boxes[CORNER_BOTTOM_RIGHT].y;
+	const float bl_x = boxes[CORNER_BOTTOM_LEFT].x, bl_y = boxes[CORNER_BOTTOM_LEFT].y;
+	StampAtlas_pushSolid(renderer, (SDL_FRect){rect.x + tl_x, rect.y, rect.w - tl_x - tr_x, (float) top}, color);
+	StampAtlas_pushSolid(renderer, (SDL_FRect){rect.x + bl_x, rect.y + rect.h - (float) bottom, rect.w - bl_x - br_x, (float) bottom}, color);
+	StampAtlas_pushSolid(renderer, (SDL_FRect){rect.x, rect.y + tl_y, (float) left, rect.h - tl_y - bl_y}, color);
+	StampAtlas_pushSolid(renderer, (SDL_FRect){rect.x + rect.w - (float) right, rect.y + tr_y, (float) right, rect.h - tr_y - br_y}, color);
 
-	SDL_RenderGeometry(renderer, NULL, vertices, vertex_count, indices, index_count);
+	return true;
 }
 
+/**
+ * Key of a rect with its clamped radii and the segment count of each corner
+ */
+static ShapeKey SDLCLAY_ShapeKey(const ShapeKind kind, const SDL_FRect rect, const Clay_CornerRadius corner_radius) {
+	ShapeKey key;
+	SDL_memset(&key, 0, sizeof(key));
+	key.kind = kind;
+	key.w = rect.w;
+	key.h = rect.h;
 
-static void SDLCLAY_RenderRoundedBorder(
+	SDLCLAY_ClampRadii(rect, corner_radius, key.radii);
+	for (int corner = 0; corner < CORNER_COUNT; corner++) {
+		key.segments[corner] = key.radii[corner] > 0 ? CornerTables_segments(key.radii[corner]) : 0;
+	}
+
+	return key;
+}
+
+static void SDLCLAY_RenderFillRoundedRect(
 	SDL_Renderer* renderer,
-	SDL_Texture* target,
-	const SDL_FRect base_rect,
-	const float corner_radius,
-	const float border_width,
-	const Clay_Color color
+	const SDL_FRect rect,
+	const Clay_CornerRadius corner_radius,
+	const Clay_Color clay_color
 ) {
-	const bool rounded = corner_radius > 0;
+	if (rect.w <= 0 || rect.h <= 0) {
+		return;
+	}
 
-	if (!rounded) {
-		SDLCLAY_SetRenderDrawColor(renderer, color);
-		SDL_RenderRect(renderer, &base_rect);
+	const SDL_FColor color = SDLCLAY_ToFColor(clay_color);
+	if (SHAPE_MODE == SDLCLAY_SHAPE_MODE_STAMPS && StampAtlas_drawFill(renderer, rect, corner_radius, color)) {
 		return;
 	}
 
-	SDL_Texture * new_target = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, (int)base_rect.w, (int)base_rect.h);
-	SDL_SetRenderTarget(renderer, new_target);
-	SDL_SetRenderDrawColor(renderer, 0,0,0,0);
-	SDL_RenderClear(renderer);
+	const ShapeKey key = SDLCLAY_ShapeKey(SHAPE_KIND_FILL, rect, corner_radius);
+	const ShapeEntry* entry = ShapeCache_get(&key);
+	if (entry != NULL) {
+		ShapeCache_draw(renderer, entry, (SDL_FPoint){rect.x, rect.y}, color);
+	}
+}
 
-	const SDL_FRect outer_rect = {
-		0,
-		0,
-		base_rect.w,
-		base_rect.h
-	};
+static void SDLCLAY_RenderBorder(
+	SDL_Renderer* renderer,
+	const SDL_FRect rect,
+	const Clay_BorderRenderData* config
+) {
+	if (rect.w <= 0 || rect.h <= 0) {
+		return;
+	}
 
-	SDLCLAY_RenderFillRoundedRect(renderer, outer_rect, corner_radius, color);
+	ShapeKey key = SDLCLAY_ShapeKey(SHAPE_KIND_BORDER, rect, config->cornerRadius);
+	key.widths[0] = SDL_min((float) config->width.left, rect.w / 2);
+	key.widths[1] = SDL_min((float) config->width.right, rect.w / 2);
+	key.widths[2] = SDL_min((float) config->width.top, rect.h / 2);
+	key.widths[3] = SDL_min((float) config->width.bottom, rect.h / 2);
 
-	const SDL_FRect inner_rect = {
-		0 + border_width,
-		0 + border_width,
-		base_rect.w - border_width * 2,
-		base_rect.h - border_width * 2
-	};
+	if (key.widths[0] <= 0 && key.widths[1] <= 0 && key.widths[2] <= 0 && key.widths[3] <= 0) {
+		return;
+	}
 
-	SDLCLAY_RenderFillRoundedRect(renderer, inner_rect, corner_radius, (Clay_Color){255, 0, 255, 0});
+	const SDL_FColor color = SDLCLAY_ToFColor(config->color);
+	if (SHAPE_MODE == SDLCLAY_SHAPE_MODE_STAMPS && StampAtlas_drawBorder(renderer, rect, config->cornerRadius, key.widths, color)) {
+		return;
+	}
 
-	SDL_SetRenderTarget(renderer, target);
-	SDL_RenderTexture(renderer, new_target, NULL, &base_rect);
-	SDL_DestroyTexture(new_target);
+	const ShapeEntry* entry = ShapeCache_get(&key);
+	if (entry != NULL) {
+		ShapeCache_draw(renderer, entry, (SDL_FPoint){rect.x, rect.y}, color);
+	}
 }
 
-void SDLCLAY_RenderCommands(SDL_Renderer* renderer, Clay_RenderCommandArray* commands_array) {
-	// Get Current Renderer size
-	int w = 0, h = 0;
-	SDL_GetCurrentRenderOutputSize(renderer, &w, &h);
-
-	// Create a texture as target
-	SDL_Texture* texture_target = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, w, h);
-	SDL_SetRenderTarget(renderer,texture_target);
-
-	// Clear
-	SDL_SetRenderDrawColor(renderer, 0,0,0,0);
-	SDL_RenderClear(renderer);
+/**
+ * Draw the commands in [begin, end) moved by offset and clipped to base_clip
+ *
+ * @param layers Whether cached layers are blitted instead of drawing their commands
+ * @param scrolls Whether cached scroll contents are blitted instead of drawing their commands
+ */
+static void SDLCLAY_DrawCommands(
+	SDL_Renderer* renderer,
+	Clay_RenderCommandArray* commands_array,
+	const int begin,
+	const int end,
+	const SDL_FPoint offset,
+	const SDL_Rect base_clip,
+	const bool clip_base,
+	const bool occlusion,
+	const bool layers,
+	const bool scrolls
+) {
+	ClipStack_reset(base_clip, clip_base);
+	ClipStack_apply();
 
-	for (int32_t i = 0; i < commands_array->length; i++) {
+	for (int32_t i = begin; i < end; i++) {
 		const Clay_RenderCommand* render_command = Clay_RenderCommandArray_Get(commands_array, i);
 		const Clay_BoundingBox bounding_box = render_command->boundingBox;
-		SDL_FRect f_rect = { bounding_box.x, bounding_box.y, bounding_box.width, bounding_box.height };
+		SDL_FRect f_rect = { bounding_box.x + offset.x, bounding_box.y + offset.y, bounding_box.width, bounding_box.height };
 		SDL_Rect rect = {(int) f_rect.x, (int) f_rect.y, (int) f_rect.w, (int) f_rect.h};
 
+		// Blit cached layers in place of their commands
+		const Layer* layer = layers ? Layers_at(i) : NULL;
+		if (layer != NULL) {
+			const SDL_FRect dst = {
+				(float) layer->rect.x + offset.x, (float) layer->rect.y + offset.y,
+				(float) layer->rect.w, (float) layer->rect.h
+			};
+			const SDL_FRect uv = {0, 0, dst.w / (float) layer->texture->w, dst.h / (float) layer->texture->h};
+
+			if (!ClipStack_culls(dst) && GeometryBatch_reserve(renderer, layer->texture, 4, 6) >= 0) {
+				GeometryBatch_pushQuad(dst, uv, (SDL_FColor){1, 1, 1, 1});
+				STATS.layer_hits++;
+			}
+			i = layer->end - 1;
+			continue;
+		}
+
+		// Blit the visible part of cached scroll contents at their scroll position
+		const ScrollCache* scroll = scrolls ? ScrollCaches_at(i) : NULL;
+		if (scroll != NULL) {
+			const SDL_FRect dst = {
+				scroll->origin.x + (float) scroll->visible.x + offset.x, scroll->origin.y + (float) scroll->visible.y + offset.y,
+				(float) scroll->visible.w, (float) scroll->visible.h
+			};
+			const SDL_FRect uv = {
+				(float) scroll->visible.x / (float) scroll->texture->w, (float) scroll->visible.y / (float) scroll->texture->h,
+				dst.w / (float) scroll->texture->w, dst.h / (float) scroll->texture->h
+			};
+
+			if (!ClipStack_culls(dst) && GeometryBatch_reserve(renderer, scroll->texture, 4, 6) >= 0) {
+				GeometryBatch_pushQuad(dst, uv, (SDL_FColor){1, 1, 1, 1});
+				STATS.scroll_blits++;
+			}
+			i = scroll->end - 1;
+			continue;
+		}
+
+		// Drop anything fully clipped before it is tessellated or rasterized
+		const Clay_RenderCommandType type = render_command->commandType;
+		if (type != CLAY_RENDER_COMMAND_TYPE_SCISSOR_START && type != CLAY_RENDER_COMMAND_TYPE_SCISSOR_END && ClipStack_culls(f_rect)) {
+			STATS.commands_culled++;
+			continue;
+		}
+		if (occlusion && OCCLUSION.commands[i].occluded) {
+			STATS.occluded_commands++;
+			STATS.occluded_pixels += (size_t) SDLCLAY_RectArea(OCCLUSION.commands[i].visible);
+			continue;
+		}
+
 		switch (render_command->commandType) {
 			// ====================================================================
 			// RECTANGLE
 			// ====================================================================
 			case CLAY_RENDER_COMMAND_TYPE_RECTANGLE: {
 				const Clay_RectangleRenderData* config = &render_command->renderData.rectangle;
-				SDLCLAY_SetRenderDrawColor(renderer, config->backgroundColor);
-				SDL_BlendMode blendMode = {0};
-				SDL_GetRenderDrawBlendMode(renderer, &blendMode);
-				SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-				if (config->cornerRadius.topLeft > 0) {
-					SDLCLAY_RenderFillRoundedRect(renderer, f_rect, config->cornerRadius.topLeft, config->backgroundColor);
+				const Clay_CornerRadius radius = config->cornerRadius;
+				if (radius.topLeft > 0 || radius.topRight > 0 || radius.bottomLeft > 0 || radius.bottomRight > 0) {
+					SDLCLAY_RenderFillRoundedRect(renderer, f_rect, radius, config->backgroundColor);
 				} else {
-					SDL_RenderFillRect(renderer, &f_rect);
+					SDLCLAY_RenderFillRect(renderer, f_rect, config->backgroundColor);
 				}
-				SDL_SetRenderDrawBlendMode(renderer, blendMode);
 			}
 			break;
 			// ====================================================================
@@ -485,21 +4424,7 @@ void SDLCLAY_RenderCommands(SDL_Renderer* renderer, Clay_RenderCommandArray* com
 			// ====================================================================
 			case CLAY_RENDER_COMMAND_TYPE_TEXT: {
 				const Clay_TextRenderData* config = &render_command->renderData.text;
-				const SDL_Color color = {
-					(int) config->textColor.r, (int) config->textColor.g,
-					(int) config->textColor.b, (int) config->textColor.a
-				};
-
-				SDL_Surface* surface = TTF_RenderText_Blended(
-					SDLCLAY_GetFont(config->fontId, config->fontSize),
-					config->stringContents.chars,
-					config->stringContents.length,
-					color
-				);
-				SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-				SDL_RenderTexture(renderer, texture, NULL, &f_rect);
-				SDL_DestroySurface(surface);
-				SDL_DestroyTexture(texture);
+				SDLCLAY_RenderText(renderer, config, f_rect);
 			}
 			break;
 			// ====================================================================
@@ -507,37 +4432,35 @@ void SDLCLAY_RenderCommands(SDL_Renderer* renderer, Clay_RenderCommandArray* com
 			// ====================================================================
 			case CLAY_RENDER_COMMAND_TYPE_BORDER: {
 				const Clay_BorderRenderData* config = &render_command->renderData.border;
-				SDLCLAY_RenderRoundedBorder(
-					renderer,
-					texture_target,
-					f_rect,
-					config->cornerRadius.topLeft,
-					config->width.top,
-					config->color
-				);
+				SDLCLAY_RenderBorder(renderer, f_rect, config);
 			}
 			break;
 			// ====================================================================
 			// IMAGE
 			// ====================================================================
 			case CLAY_RENDER_COMMAND_TYPE_IMAGE: {
-				const Clay_ImageRenderData* config = &render_command->renderData.image;
-				SDL_Texture* texture = config->imageData;
-				SDL_RenderTexture(renderer, texture, NULL, &f_rect);
+				// Consecutive images of an atlas page are drawn in one batch
+				SDL_FRect uv = {0};
+				SDL_Texture* texture = SDLCLAY_ResolveImage(render_command->renderData.image.imageData, f_rect.w, f_rect.h, &uv);
+				if (texture != NULL && GeometryBatch_reserve(renderer, texture, 4, 6) >= 0) {
+					GeometryBatch_pushQuad(f_rect, uv, (SDL_FColor){1, 1, 1, 1});
+				}
 			}
 			break;
 			// ====================================================================
 			// SCISSOR START
 			// ====================================================================
 			case CLAY_RENDER_COMMAND_TYPE_SCISSOR_START: {
-				SDL_SetRenderClipRect(renderer, &rect);
+				ClipStack_push(rect);
+				ClipStack_apply();
 			}
 			break;
 			// ====================================================================
 			// SCISSOR END
 			// ====================================================================
 			case CLAY_RENDER_COMMAND_TYPE_SCISSOR_END: {
-				SDL_SetRenderClipRect(renderer, NULL);
+				ClipStack_pop();
+				ClipStack_apply();
 			}
 			break;
 			default:
@@ -545,15 +4468,329 @@ void SDLCLAY_RenderCommands(SDL_Renderer* renderer, Clay_RenderCommandArray* com
 		}
 	}
 
-	SDL_BlendMode blend_mode = {0};
-	SDL_GetRenderDrawBlendMode(renderer, &blend_mode);
-	SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+	GeometryBatch_flush(renderer);
+}
+
+/**
+ * Redraw the textures of the layers laid out this frame whose commands changed,
+ * then go back to target
+ */
+static void Layers_update(SDL_Renderer* renderer, Clay_RenderCommandArray* commands_array, SDL_Texture* target) {
+	for (int i = 0; i < LAYERS.count; i++) {
+		Layer* layer = &LAYERS.layers[i];
+		if (layer->begin < 0 || layer->rect.w <= 0 || layer->rect.h <= 0) {
+			continue;
+		}
+
+		const uint64_t hash = Layer_fingerprint(layer, commands_array);
+
+		const bool fits = layer->texture != NULL && layer->texture->w >= layer->rect.w && layer->texture->h >= layer->rect.h;
+		if (fits && layer->hash == hash) {
+			layer->last_frame = FRAME_INDEX;
+			continue;
+		}
+
+		if (!fits) {
+			Layers_releaseTexture(layer->texture);
+			layer->texture = Layers_acquireTexture(renderer, layer->rect.w, layer->rect.h);
+			if (layer->texture == NULL) {
+				continue;
+			}
+		}
+
+		RenderState_setTarget(layer->texture);
+		RenderState_setClip(NULL);
+		RenderState_setColor((SDL_Color){0, 0, 0, 0});
+		SDL_RenderClear(renderer);
+
+		// Occlusion is left out, what hides the layer this frame may move away
+		const SDL_Rect layer_clip = {0, 0, layer->rect.w, layer->rect.h};
+		const SDL_FPoint offset = {(float) -layer->rect.x, (float) -layer->rect.y};
+		SDLCLAY_DrawCommands(renderer, commands_array, layer->begin, layer->end, offset, layer_clip, true, false, false, false);
+
+		layer->hash = hash;
+		layer->last_frame = FRAME_INDEX;
+		STATS.layer_renders++;
+	}
+
+	RenderState_setTarget(target);
+	Layers_trim();
+}
+
+/**
+ * Clear an area of the current target to transparent
+ */
+static void SDLCLAY_ClearRect(SDL_Renderer* renderer, const SDL_Rect rect) {
+	const SDL_FRect f_rect = {(float) rect.x, (float) rect.y, (float) rect.w, (float) rect.h};
+	RenderState_setClip(&rect);
+	RenderState_setBlendMode(SDL_BLENDMODE_NONE);
+	RenderState_setColor((SDL_Color){0, 0, 0, 0});
+	STATS.draw_calls++;
+	SDL_RenderFillRect(renderer, &f_rect);
+	RenderState_setBlendMode(SDL_BLENDMODE_BLEND);
+}
+
+/**
+ * Bring the textures of the cached scroll contents up to date with the visible area,
+ * then go back to target
+ */
+static void ScrollCaches_update(SDL_Renderer* renderer, Clay_RenderCommandArray* commands_array, SDL_Texture* target) {
+	for (int i = 0; i < SCROLL_CACHES.count; i++) {
+		ScrollCache* cache = &SCROLL_CACHES.caches[i];
+		if (cache->begin < 0) {
+			continue;
+		}
+
+		const int count = cache->end - cache->begin;
+		if (!SDLCLAY_GrowBuffer((void**) &SCROLL_CACHES.current, &SCROLL_CACHES.current_capacity, count, sizeof(CommandRecord))) {
+			cache->begin = -1;
+			continue;
+		}
+
+		const Clay_ScrollContainerData data = Clay_GetScrollContainerData((Clay_ElementId){.id = cache->id});
+		const int content_w = (int) SDL_ceilf(data.contentDimensions.width);
+		const int content_h = (int) SDL_ceilf(data.contentDimensions.height);
+
+		if (cache->texture == NULL || cache->texture->w < content_w || cache->texture->h < content_h) {
+			Layers_releaseTexture(cache->texture);
+			cache->texture = Layers_acquireTexture(renderer, content_w, content_h);
+			ScrollCache_reset(cache);
+			if (cache->texture == NULL) {
+				cache->begin = -1;
+				continue;
+			}
+		}
+
+		// Anything changed in the content already drawn makes the whole visible area redrawn
+		const uint64_t style = Fingerprint_style();
+		const bool unchanged = ScrollCache_diff(cache, commands_array);
+		if (!unchanged || cache->style != style) {
+			ScrollCache_reset(cache);
+			cache->style = style;
+			STATS.scroll_full_redraws++;
+		}
+
+		// The valid area must stay a rect, scrolling along one axis extends it
+		SDL_Rect merged = cache->visible;
+		SDL_Rect overlap = {0};
+		if (!SDL_RectEmpty(&cache->valid)) {
+			SDL_GetRectUnion(&cache->valid, &cache->visible, &merged);
+			SDL_GetRectIntersection(&cache->valid, &cache->visible, &overlap);
+			const int64_t covered = (int64_t) cache->valid.w * cache->valid.h + (int64_t) cache->visible.w * cache->visible.h - (int64_t) overlap.w * overlap.h;
+			if ((int64_t) merged.w * merged.h != covered) {
+				ScrollCache_reset(cache);
+				merged = cache->visible;
+				overlap = (SDL_Rect){0};
+			}
+		}
+
+		// Strips of the visible area outside the valid one
+		SDL_Rect strips[4];
+		int strip_count = 0;
+		const SDL_Rect visible = cache->visible;
+		if (SDL_RectEmpty(&overlap)) {
+			strips[strip_count++] = visible;
+		} else {
+			const int top = overlap.y - visible.y;
+			const int bottom = visible.y + visible.h - (overlap.y + overlap.h);
+			const int left = overlap.x - visible.x;
+			const int right = visible.x + visible.w - (overlap.x + overlap.w);
+			if (top > 0) {
+				strips[strip_count++] = (SDL_Rect){visible.x, visible.y, visible.w, top};
+			}
+			if (bottom > 0) {
+				strips[strip_count++] = (SDL_Rect){visible.x, overlap.y + overlap.h, visible.w, bottom};
+			}
+			if (left > 0) {
+				strips[strip_count++] = (SDL_Rect){visible.x, overlap.y, left, overlap.h};
+			}
+			if (right > 0) {
+				strips[strip_count++] = (SDL_Rect){overlap.x + overlap.w, overlap.y, right, overlap.h};
+			}
+		}
+
+		if (strip_count > 0) {
+			RenderState_setTarget(cache->texture);
+			const SDL_FPoint offset = {-cache->origin.x, -cache->origin.y};
+			for (int j = 0; j < strip_count; j++) {
+				SDLCLAY_ClearRect(renderer, strips[j]);
+				SDLCLAY_DrawCommands(renderer, commands_array, cache->begin, cache->end, offset, strips[j], true, false, true, false);
+				STATS.scroll_strips++;
+			}
+		}
+
+		cache->valid = merged;
+		ScrollCache_store(cache, count);
+	}
+
+	RenderState_setTarget(target);
+}
+
+void SDLCLAY_RenderCommands(SDL_Renderer* renderer, Clay_RenderCommandArray* commands_array) {
+	FRAME_INDEX++;
+	STATS.text_rasterizations = 0;
+
+	// Glyphs are uploaded before fingerprinting, a new generation redraws the placeholders
+	STATS.glyph_jobs = 0;
+	STATS.glyph_uploads = 0;
+	STATS.glyph_placeholders = 0;
+	if (GLYPH_WORKERS.count > 0) {
+		const bool block = GLYPH_WORKERS.policy == SDLCLAY_GLYPH_POLICY_BLOCK;
+		if (block) {
+			GlyphWorkers_prefetch(renderer, commands_array);
+		}
+		GlyphAtlas_bind(renderer);
+		GlyphWorkers_collect(renderer, block);
+	}
+
+	const bool offscreen = RENDER_MODE == SDLCLAY_RENDER_MODE_OFFSCREEN;
+	const bool damage = DAMAGE_REDRAW && offscreen;
+	const uint64_t settings = Fingerprint_settings(renderer);
+	CommandRecord* records = damage ? Damage_records(commands_array->length) : NULL;
+	if (!damage) {
+		DAMAGE.valid = false;
+	}
+
+	// A frame invalidated by the app must be redrawn entirely
+	if (!FINGERPRINT.valid) {
+		DAMAGE.valid = false;
+	}
+	FINGERPRINT.frame = Fingerprint_frame(commands_array, settings, records);
+	FINGERPRINT.valid = true;
+	STATS.text_cache_hits = 0;
+	STATS.text_cache_misses = 0;
+	STATS.text_cache_evictions = 0;
+	STATS.font_size_evictions = 0;
+	STATS.upload_ring_uploads = 0;
+	STATS.upload_ring_recycles = 0;
+	STATS.image_variants = 0;
+	STATS.draw_calls = 0;
+	STATS.geometry_allocations = 0;
+	STATS.state_calls_issued = 0;
+	STATS.state_calls_elided = 0;
+	STATS.shape_cache_hits = 0;
+	STATS.shape_cache_misses = 0;
+	STATS.stamp_rasterizations = 0;
+	GeometryArena_reset();
+	RenderState_begin(renderer);
+
+	// Get Current Renderer size
+	int w = 0, h = 0;
+	SDL_GetCurrentRenderOutputSize(renderer, &w, &h);
+
+	SDL_Texture* texture_target = NULL;
+
+	// State of the caller's target, restored once commands are drawn
+	SDL_Texture* previous_target = RENDER_STATE.target;
+	const SDL_Color previous_color = RENDER_STATE.color;
+	const SDL_BlendMode previous_blend_mode = RENDER_STATE.blend_mode;
+	const SDL_Rect previous_clip = RENDER_STATE.clip;
+	const bool previous_clip_enabled = RENDER_STATE.clip_enabled;
+	float previous_scale_x = 1.0f, previous_scale_y = 1.0f;
+
+	if (offscreen) {
+		// Reuse the composition target of the previous frames
+		texture_target = RenderTarget_acquire(renderer, w, h);
+		if (texture_target == NULL) {
+			return;
+		}
+		RenderState_setTarget(texture_target);
+	} else {
+		// Draw straight into the caller's target, with the same unscaled
+		// coordinates the offscreen target would use
+		SDL_GetRenderScale(renderer, &previous_scale_x, &previous_scale_y);
+		SDL_SetRenderScale(renderer, 1.0f, 1.0f);
+	}
+
+	// Every batched untextured shape is alpha blended
+	RenderState_setBlendMode(SDL_BLENDMODE_BLEND);
+
+	STATS.commands_culled = 0;
+	STATS.occluded_commands = 0;
+	STATS.occluded_pixels = 0;
+	if (OCCLUSION_CULLING) {
+		Occlusion_run(commands_array, w, h);
+	}
+	const bool occlusion = OCCLUSION_CULLING && OCCLUSION.capacity >= commands_array->length;
+
+	STATS.layer_renders = 0;
+	STATS.layer_hits = 0;
+	STATS.layer_evictions = 0;
+	if (LAYERS.renderer != renderer) {
+		// Textures belong to the renderer they were created with
+		Layers_releaseAll();
+		for (int i = 0; i < SCROLL_CACHES.count; i++) {
+			if (SCROLL_CACHES.caches[i].texture != NULL) {
+				Layers_destroyTexture(SCROLL_CACHES.caches[i].texture);
+				SCROLL_CACHES.caches[i].texture = NULL;
+			}
+		}
+		LAYERS.renderer = renderer;
+	}
+	if (LAYERS.count > 0) {
+		Layers_resolve(commands_array);
+		Layers_update(renderer, commands_array, offscreen ? texture_target : previous_target);
+	}
+
+	STATS.scroll_blits = 0;
+	STATS.scroll_strips = 0;
+	STATS.scroll_full_redraws = 0;
+	if (SCROLL_CACHES.count > 0) {
+		ScrollCaches_resolve(commands_array, w, h);
+		ScrollCaches_update(renderer, commands_array, offscreen ? texture_target : previous_target);
+	}
+	STATS.layer_bytes = LAYERS.bytes;
+
+	const SDL_Rect viewport = {0, 0, w, h};
+	const SDL_FPoint origin = {0, 0};
+	const bool partial = records != NULL && Damage_compute(settings, commands_array->length, w, h);
+	STATS.full_redraw = !partial;
+	STATS.damage_rects = 0;
+	STATS.damaged_pixels = (size_t) w * (size_t) h;
+
+	if (partial) {
+		// Everything else of the target is still valid from the previous frames
+		STATS.damage_rects = DAMAGE.rect_count;
+		STATS.damaged_pixels = 0;
+		for (int i = 0; i < DAMAGE.rect_count; i++) {
+			STATS.damaged_pixels += (size_t) DAMAGE.rects[i].w * (size_t) DAMAGE.rects[i].h;
+			SDLCLAY_ClearRect(renderer, DAMAGE.rects[i]);
+			SDLCLAY_DrawCommands(renderer, commands_array, 0, commands_array->length, origin, DAMAGE.rects[i], true, occlusion, true, true);
+		}
+	} else {
+		if (offscreen) {
+			// Clear, the clip of the target may be left over from the last frame
+			RenderState_setClip(NULL);
+			RenderState_setColor((SDL_Color){0, 0, 0, 0});
+			SDL_RenderClear(renderer);
+		}
+		SDLCLAY_DrawCommands(renderer, commands_array, 0, commands_array->length, origin, viewport, false, occlusion, true, true);
+	}
+
+	if (offscreen) {
+		// Only the top left w*h area of the target is in use
+		const SDL_FRect used_rect = {0, 0, (float) w, (float) h};
+		RenderState_setTarget(previous_target);
+		STATS.draw_calls++;
+		SDL_RenderTexture(renderer, texture_target, &used_rect, NULL);
+	} else {
+		SDL_SetRenderScale(renderer, previous_scale_x, previous_scale_y);
+	}
 
-	SDL_SetRenderTarget(renderer, NULL);
-	SDL_RenderTexture(renderer, texture_target, NULL, NULL);
-	SDL_DestroyTexture(texture_target);
+	RenderState_setClip(previous_clip_enabled ? &previous_clip : NULL);
+	RenderState_setBlendMode(previous_blend_mode);
+	RenderState_setColor(previous_color);
 
-	SDL_SetRenderDrawBlendMode(renderer, blend_mode);
+	TextCache_trim();
+	Fonts_trim();
+	STATS.geometry_vertices = GEOMETRY_ARENA.vertex_count;
+	STATS.geometry_indices = GEOMETRY_ARENA.index_count;
+	STATS.geometry_vertex_high_water = GEOMETRY_ARENA.vertex_high_water;
+	STATS.geometry_index_high_water = GEOMETRY_ARENA.index_high_water;
+	STATS.text_cache_bytes = TEXT_CACHE.bytes;
+	STATS.image_standalone_textures = IMAGE_ATLAS.standalone_count;
+	STATS.upload_ring_bytes = (size_t) UPLOAD_RING.page_count * SDLCLAY_UPLOAD_RING_PAGE_SIZE * SDLCLAY_UPLOAD_RING_PAGE_SIZE * 4;
+	STATS.text_cache_entries = TEXT_CACHE.count;
 }
 
 // ===================================================================================
@@ -569,6 +4806,107 @@ void SDLCLAY_SetAllocator(const SDLCLAY_Fun_Malloc fun_malloc, const SDLCLAY_Fun
 	SDLCLAY_FREE = fun_free;
 }
 
+void SDLCLAY_SetRenderMode(const SDLCLAY_RenderMode mode) {
+	RENDER_MODE = mode;
+}
+
+SDLCLAY_RenderMode SDLCLAY_GetRenderMode() {
+	return RENDER_MODE;
+}
+
+void SDLCLAY_SetCornerTolerance(const float tolerance) {
+	CORNER_TOLERANCE = SDL_max(tolerance, 0.01f);
+}
+
+void SDLCLAY_SetShapeMode(const SDLCLAY_ShapeMode mode) {
+	SHAPE_MODE = mode;
+}
+
+SDLCLAY_ShapeMode SDLCLAY_GetShapeMode() {
+	return SHAPE_MODE;
+}
+
+void SDLCLAY_SetOcclusionCulling(const bool enabled) {
+	OCCLUSION_CULLING = enabled;
+}
+
+void SDLCLAY_SetDamageRedraw(const bool enabled) {
+	DAMAGE_REDRAW = enabled;
+}
+
+bool SDLCLAY_SetGlyphWorkers(const int worker_count, const SDLCLAY_GlyphPolicy policy) {
+	GlyphWorkers_stop();
+
+	const int count = SDL_min(worker_count, SDLCLAY_GLYPH_WORKERS_MAX);
+	if (count <= 0) {
+		return true;
+	}
+
+	GLYPH_WORKERS.policy = policy;
+	GLYPH_WORKERS.lock = SDL_CreateMutex();
+	GLYPH_WORKERS.work = SDL_CreateCondition();
+	GLYPH_WORKERS.finished = SDL_CreateCondition();
+	GLYPH_WORKERS.queue = SDLCLAY_MALLOC(SDLCLAY_GLYPH_QUEUE_CAPACITY * sizeof(GlyphJob));
+	GLYPH_WORKERS.done = SDLCLAY_MALLOC(SDLCLAY_GLYPH_QUEUE_CAPACITY * sizeof(GlyphJob));
+	if (
+		GLYPH_WORKERS.lock == NULL || GLYPH_WORKERS.work == NULL || GLYPH_WORKERS.finished == NULL ||
+		GLYPH_WORKERS.queue == NULL || GLYPH_WORKERS.done == NULL || !Fonts_setThreaded(true)
+	) {
+		SDLCLAY_LOG("Failed to start glyph workers: %s", SDL_GetError());
+		GlyphWorkers_stop();
+		return false;
+	}
+
+	for (int i = 0; i < count; i++) {
+		GlyphWorker* worker = &GLYPH_WORKERS.workers[GLYPH_WORKERS.count];
+		worker->thread = SDL_CreateThread(GlyphWorker_run, "SDLCLAY glyphs", worker);
+		if (worker->thread == NULL) {
+			SDLCLAY_LOG("Failed to create glyph worker: %s", SDL_GetError());
+			break;
+		}
+		GLYPH_WORKERS.count++;
+	}
+
+	if (GLYPH_WORKERS.count == 0) {
+		GlyphWorkers_stop();
+		return false;
+	}
+	return true;
+}
+
+void SDLCLAY_SetTextMode(const SDLCLAY_TextMode mode) {
+	// Scalable text is measured differently, Clay must measure everything again
+	if (mode != TEXT_MODE && Clay_GetCurrentContext() != NULL) {
+		Clay_ResetMeasureTextCache();
+	}
+	TEXT_MODE = mode;
+
+	// Scalable text is filtered linearly whatever its size, unscaled glyphs snapped
+	// to pixels look the same either way
+	GlyphAtlas_setScaleMode(mode == SDLCLAY_TEXT_MODE_SCALABLE ? SDL_SCALEMODE_LINEAR : SDL_SCALEMODE_NEAREST);
+}
+
+SDLCLAY_TextMode SDLCLAY_GetTextMode() {
+	return TEXT_MODE;
+}
+
+const SDLCLAY_Stats* SDLCLAY_GetStats() {
+	return &STATS;
+}
+
 void SDLCLAY_Quit() {
-	FontHolder_free(&FONTS_HOLDER);
+	SDLCLAY_ReleaseRenderTarget();
+	TextCache_free();
+	UploadRing_free();
+	GlyphWorkers_stop();
+	ImageAtlas_free();
+	GlyphAtlas_free();
+	GeometryBatch_free();
+	Occlusion_free();
+	Damage_free();
+	ScrollCaches_free();
+	ShapeCache_free();
+	StampAtlas_free();
+	Layers_free();
+	Fonts_free();
 }
\ No newline at end of file
@@ -27,24 +27,101 @@ void SDLCLAY_SetLogger(SDLCLAY_Fun_Logger logger);
 void SDLCLAY_SetAllocator(SDLCLAY_Fun_Malloc fun_malloc, SDLCLAY_Fun_Free fun_free);
 
 /**
- * Free all resources used by SDLCLAY
+ * Free all resources used by SDLCLAY, call it before destroying the renderer
  */
 void SDLCLAY_Quit();
 
+/**
+ * Counters of the last frame rendered by SDLCLAY_RenderCommands
+ */
+typedef struct SDLCLAY_Stats {
+	// Draw calls submitted to the SDL renderer
+	int draw_calls;
+	// Geometry tessellated this frame and the most ever needed in one frame
+	int geometry_vertices;
+	int geometry_indices;
+	int geometry_vertex_high_water;
+	int geometry_index_high_water;
+	// Growths of the geometry arena, zero once it reached its high-water mark
+	int geometry_allocations;
+	// SDL state calls (target, draw color, blend mode, clip) made or skipped as redundant
+	int state_calls_issued;
+	int state_calls_elided;
+	// Rounded rects and borders whose tessellation was reused or built
+	int shape_cache_hits;
+	int shape_cache_misses;
+	// Corner stamps rasterized in SDLCLAY_SHAPE_MODE_STAMPS
+	int stamp_rasterizations;
+	// Commands dropped because they were outside the active clip or the viewport
+	int commands_culled;
+	// Commands skipped because opaque commands drawn after them hide them entirely,
+	// and the pixels they would have covered
+	int occluded_commands;
+	size_t occluded_pixels;
+	// Whether the whole output was redrawn, otherwise only damage_rects covering damaged_pixels
+	bool full_redraw;
+	int damage_rects;
+	size_t damaged_pixels;
+	// Cached layers redrawn in their texture, blitted from it and evicted
+	int layer_renders;
+	int layer_hits;
+	int layer_evictions;
+	size_t layer_bytes;
+	// Cached scroll contents blitted, strips drawn in their textures and full redraws of them
+	int scroll_blits;
+	int scroll_strips;
+	int scroll_full_redraws;
+	// Strings or glyphs rasterized with SDL_ttf, zero on steady-state frames
+	int text_rasterizations;
+	int text_cache_hits;
+	int text_cache_misses;
+	int text_cache_evictions;
+	// Current size of the string cache, strings held by the upload ring excluded
+	size_t text_cache_bytes;
+	int text_cache_entries;
+	// Strings written in the upload ring and ring pages overwritten
+	int upload_ring_uploads;
+	int upload_ring_recycles;
+	// Size of the ring pages created so far, apart from the string cache budget
+	size_t upload_ring_bytes;
+	// Scaled image variants built the first time an image was drawn larger
+	int image_variants;
+	// Images in a texture of their own, larger than SDLCLAY_IMAGE_ATLAS_MAX_SIZE or out of atlas space
+	int image_standalone_textures;
+	// Glyphs queued to the glyph workers, uploaded from them and drawn as placeholders
+	int glyph_jobs;
+	int glyph_uploads;
+	int glyph_placeholders;
+	// Font sizes open and sizes closed after SDLCLAY_FONT_SIZE_IDLE_FRAMES frames unused
+	int font_sizes;
+	int font_size_evictions;
+} SDLCLAY_Stats;
+
+/**
+ * Get the counters of the last rendered frame
+ * @return Pointer to the internal stats, valid until SDLCLAY_Quit
+ */
+const SDLCLAY_Stats* SDLCLAY_GetStats();
+
 // ===================================================================================
 // MARK: Fonts
 // ===================================================================================
 
 /**
- * Base capacity of a node of the holder before requiring
- * an extra node in the chained list
+ * Largest font size accepted, sizes can be fractional
+ */
+#define SDLCLAY_FONT_MAX_SIZE 4096
+
+/**
+ * Sizes other than the initial one are closed once not requested for this many
+ * rendered frames, and reopened when needed again
  */
-#define SDLCLAY_FONT_HOLDER_CAPACITY 32
-#define SDLCLAY_FONT_MAX_SIZE 256
+#define SDLCLAY_FONT_SIZE_IDLE_FRAMES 600
 
 /**
- * Add font to the SDLCLAY font holder, it will preload the initial size
- * and will lazy load any other requested size. It will load it with TTF_OpenFont
+ * Add font to the SDLCLAY font registry, it will preload the initial size
+ * and will lazy load any other requested size. The file is read once and every
+ * size is opened with TTF_OpenFontIO from that same memory
  *
  * You can preload them by just requesting them with SDLCLAY_GetFont
  *
@@ -52,11 +129,12 @@ void SDLCLAY_Quit();
  * @param init_size Initial size to preload
  * @return Font index to get it back with SDLCLAY_GetFont or to use in Clay elements
  */
-int SDLCLAY_AddFont(const char * font_path, int init_size);
+int SDLCLAY_AddFont(const char * font_path, float init_size);
 
 /**
- * Add font to the SDLCLAY font holder, it will preload the initial size
- * and will lazy load any other requested size.
+ * Add font to the SDLCLAY font registry, it will preload the initial size
+ * and will lazy load any other requested size, copied with TTF_CopyFont.
+ * The font stays owned by the caller and must outlive the registry.
  *
  * You can preload them by just requesting them with SDLCLAY_GetFont
  *
@@ -64,28 +142,340 @@ int SDLCLAY_AddFont(const char * font_path, int init_size);
  * @param init_size Initial size to preload
  * @return Font index to get it back with SDLCLAY_GetFont or to use in Clay elements
  */
-int SDLCLAY_AddFontRaw(TTF_Font * font, int init_size);
+int SDLCLAY_AddFontRaw(TTF_Font * font, float init_size);
 
 /**
- * Get the font from the SDLCLAY font holder.
+ * Get the font from the SDLCLAY font registry.
  *
- * @param font_index Index of the font in the font holder.
+ * @param font_index Index of the font in the font registry.
  * @param size Size of the font to retrieve.
- * @return Pointer to the TTF_Font structure.
+ * @return Pointer to the TTF_Font structure, NULL if the index or size is invalid.
+ * Sizes other than the initial one may be closed by SDLCLAY_RenderCommands once idle.
  */
-TTF_Font* SDLCLAY_GetFont(int font_index, int size);
+TTF_Font* SDLCLAY_GetFont(int font_index, float size);
+
+/**
+ * Slots of the cache of line heights and ASCII advances per font and size,
+ * and of the kerning pairs cached for each of them
+ */
+#define SDLCLAY_METRICS_CACHE_SIZE 32
+#define SDLCLAY_KERNING_CACHE_SIZE 256
 
 /**
  * Measure Function to Bind to Clay
+ *
+ * Printable ASCII text is measured from cached advances and kerning, anything else
+ * with TTF_MeasureString.
  */
 Clay_Dimensions SDLCLAY_MeasureText(Clay_StringSlice text, Clay_TextElementConfig* config, void* userData);
 
+/**
+ * Debug check of the cached measurements, every ASCII text is also measured with
+ * TTF_MeasureString and differences are logged. Disabled by default.
+ * @param enabled true to verify measurements
+ */
+void SDLCLAY_SetMeasureVerification(bool enabled);
+
+// ===================================================================================
+// MARK: Images
+// ===================================================================================
+
+/**
+ * Images up to SDLCLAY_IMAGE_ATLAS_MAX_SIZE pixels are packed in shared atlas pages of
+ * SDLCLAY_IMAGE_ATLAS_PAGE_SIZE pixels, so consecutive ones are drawn in a single call
+ */
+#define SDLCLAY_IMAGE_ATLAS_PAGE_SIZE 1024
+#define SDLCLAY_IMAGE_ATLAS_MAX_PAGES 4
+#define SDLCLAY_IMAGE_ATLAS_MAX_SIZE 512
+
+/**
+ * Areas of destroyed images remembered per atlas page and reused by new images. Space
+ * beyond that is only reclaimed once the page holds no image anymore.
+ */
+#define SDLCLAY_IMAGE_ATLAS_FREE_RECTS 64
+
+/**
+ * Most variants of an image created with SDLCLAY_CreateImageScaled
+ */
+#define SDLCLAY_IMAGE_MAX_VARIANTS 4
+
+typedef struct SDLCLAY_Image SDLCLAY_Image;
+
+/**
+ * Create an image to use as Clay imageData, packed in the image atlas when small enough
+ * or in a texture of its own otherwise. Clay imageData can still be a plain SDL_Texture.
+ *
+ * @param renderer Renderer the image is drawn with
+ * @param surface Pixels of the image, not kept
+ * @return Image handle, NULL on failure
+ */
+SDLCLAY_Image* SDLCLAY_CreateImage(SDL_Renderer* renderer, SDL_Surface* surface);
+
+/**
+ * Create an image downscaled to the size in pixels it is drawn at. With more than one variant,
+ * an image drawn larger uses variants doubling in size up to the one of the surface, each
+ * scaled down the first time it is needed from a copy of the surface. That copy is kept
+ * until every variant is built, so only ask for variants when the drawn size changes.
+ *
+ * @param renderer Renderer the image is drawn with
+ * @param surface Pixels of the image, copied only when variants are yet to be built
+ * @param w, h Size of the smallest variant, shrunk uniformly when larger than the surface
+ * @param max_variants Most variants, up to SDLCLAY_IMAGE_MAX_VARIANTS, 1 for a fixed size image
+ * @return Image handle, NULL on failure
+ */
+SDLCLAY_Image* SDLCLAY_CreateImageScaled(SDL_Renderer* renderer, SDL_Surface* surface, int w, int h, int max_variants);
+
+/**
+ * Destroy an image, before SDLCLAY_Quit
+ * @param image Image to destroy, can be NULL
+ */
+void SDLCLAY_DestroyImage(SDLCLAY_Image* image);
+
+/**
+ * Draw an image outside of Clay commands, with the variant matching the size it is drawn at
+ * @param dst Destination in render coordinates, NULL for the whole target
+ */
+void SDLCLAY_RenderImage(SDL_Renderer* renderer, SDLCLAY_Image* image, const SDL_FRect* dst);
+
 // ===================================================================================
 // MARK: Render
 // ===================================================================================
 
+/**
+ * Maximum number of segments used to tessellate a rounded corner, the actual count
+ * depends on the on-screen radius and the tolerance set with SDLCLAY_SetCornerTolerance
+ */
 #define SDLCLAY_NUM_SEGMENT_CORNER 32
 
+/**
+ * Set the maximum distance in pixels between a tessellated corner and the true arc,
+ * default to 0.25. Lower values produce smoother but heavier corners.
+ * @param tolerance Error tolerance in on-screen pixels
+ */
+void SDLCLAY_SetCornerTolerance(float tolerance);
+
+/**
+ * Maximum nesting of scissor elements, deeper scissors keep the clip of their parent
+ */
+#define SDLCLAY_CLIP_STACK_CAPACITY 64
+
+/**
+ * Optional pass walking the commands back to front to skip those entirely hidden
+ * by opaque rectangles and images drawn after them. Only the
+ * SDLCLAY_OCCLUSION_MAX_OCCLUDERS largest opaque areas are tracked.
+ */
+#define SDLCLAY_OCCLUSION_MAX_OCCLUDERS 16
+
+/**
+ * Enable the occlusion pass, default to false.
+ * Worth it when opaque panels are stacked over each other.
+ * @param enabled Whether hidden commands are skipped
+ */
+void SDLCLAY_SetOcclusionCulling(bool enabled);
+
+/**
+ * In SDLCLAY_RENDER_MODE_OFFSCREEN with damage redraw enabled, commands are diffed with
+ * those of the previous frame and only the areas that changed are redrawn in the
+ * composition target, merged into at most SDLCLAY_DAMAGE_MAX_RECTS rects. The whole
+ * output is redrawn when the commands are added or removed, or when the damaged area
+ * exceeds SDLCLAY_DAMAGE_MAX_COVERAGE of the output.
+ */
+#define SDLCLAY_DAMAGE_MAX_RECTS 8
+#define SDLCLAY_DAMAGE_MAX_COVERAGE 0.5f
+
+/**
+ * Enable damage redraw, default to false
+ * @param enabled Whether only changed areas are redrawn
+ */
+void SDLCLAY_SetDamageRedraw(bool enabled);
+
+/**
+ * Cached layers are drawn once in a texture and blitted until their commands change.
+ * At most SDLCLAY_LAYER_MAX_COUNT elements can be cached, their textures are pooled in
+ * SDLCLAY_LAYER_GRANULARITY steps and the least recently drawn are evicted when they
+ * exceed SDLCLAY_LAYER_CACHE_BUDGET bytes.
+ */
+#define SDLCLAY_LAYER_MAX_COUNT 32
+#define SDLCLAY_LAYER_GRANULARITY 64
+#define SDLCLAY_LAYER_CACHE_BUDGET (32 * 1024 * 1024)
+
+/**
+ * Mark an element as a cached layer, worth it for static subtrees.
+ * The element needs a background color or a scroll so it emits the first command
+ * of its subtree, the layer then covers the following commands within its bounds.
+ *
+ * @param element_id Id of the element, as given to its declaration
+ * @param cached Whether the element is cached, false releases its texture
+ */
+void SDLCLAY_SetLayerCached(Clay_ElementId element_id, bool cached);
+
+/**
+ * Content of cached scroll containers is drawn in a texture as large as the content,
+ * up to SDLCLAY_SCROLL_CACHE_MAX_SIZE pixels on each axis, then blitted at the scroll
+ * position. Only the strips scrolled into view are drawn. Their textures share the
+ * pool and budget of cached layers.
+ */
+#define SDLCLAY_SCROLL_CACHE_MAX_COUNT 8
+#define SDLCLAY_SCROLL_CACHE_MAX_SIZE 4096
+
+/**
+ * Mark a scroll container as cached. Its background and border are drawn as usual.
+ * Changes of the content already drawn redraw the whole visible area.
+ * Uses Clay_GetScrollContainerData, render the commands of the current Clay context.
+ *
+ * @param element_id Id of the scroll container, as given to its declaration
+ * @param cached Whether the content is cached, false releases its texture
+ */
+void SDLCLAY_SetScrollCached(Clay_ElementId element_id, bool cached);
+
+/**
+ * Slots of the cache of tessellated rounded rects and borders, keyed by size, radii,
+ * border widths and segment counts. Cached shapes are only moved and colored each frame.
+ */
+#define SDLCLAY_SHAPE_CACHE_SIZE 256
+
+typedef enum SDLCLAY_ShapeMode {
+	// Rounded rects and borders tessellated into triangles
+	SDLCLAY_SHAPE_MODE_GEOMETRY,
+	// Rounded corners drawn from anti-aliased stamps and sides as quads. Radii and border
+	// widths are rounded to whole pixels, corners thinner than their border and radii above
+	// SDLCLAY_STAMP_MAX_RADIUS fall back to the geometry.
+	SDLCLAY_SHAPE_MODE_STAMPS,
+} SDLCLAY_ShapeMode;
+
+/**
+ * Corner stamps are rasterized once per radius and border widths
+ * into an atlas page of SDLCLAY_STAMP_ATLAS_PAGE_SIZE pixels
+ */
+#define SDLCLAY_STAMP_ATLAS_PAGE_SIZE 512
+#define SDLCLAY_STAMP_MAX_COUNT 256
+#define SDLCLAY_STAMP_MAX_RADIUS 128
+
+/**
+ * Select how rounded rects and borders are drawn, default to SDLCLAY_SHAPE_MODE_GEOMETRY
+ * @param mode Shape mode to use
+ */
+void SDLCLAY_SetShapeMode(SDLCLAY_ShapeMode mode);
+
+/**
+ * @return The current shape mode
+ */
+SDLCLAY_ShapeMode SDLCLAY_GetShapeMode();
+
+/**
+ * Glyphs of every font and size are rasterized once and packed
+ * into shared atlas pages of SDLCLAY_GLYPH_ATLAS_PAGE_SIZE pixels.
+ * When all SDLCLAY_GLYPH_ATLAS_MAX_PAGES are full the atlas is recycled.
+ */
+#define SDLCLAY_GLYPH_ATLAS_PAGE_SIZE 1024
+#define SDLCLAY_GLYPH_ATLAS_MAX_PAGES 4
+
+/**
+ * The string cache keeps the texture of each rendered string, entries not drawn
+ * for SDLCLAY_TEXT_CACHE_MAX_AGE frames or least recently drawn when the cache
+ * exceeds SDLCLAY_TEXT_CACHE_BUDGET bytes are evicted
+ */
+#define SDLCLAY_TEXT_CACHE_MAX_AGE 120
+#define SDLCLAY_TEXT_CACHE_BUDGET (16 * 1024 * 1024)
+
+/**
+ * Cached strings are written in a ring of SDLCLAY_UPLOAD_RING_PAGES streaming textures
+ * of SDLCLAY_UPLOAD_RING_PAGE_SIZE pixels, the oldest page is overwritten once all are full.
+ * Larger strings get a texture of their own. Only those count in SDLCLAY_TEXT_CACHE_BUDGET,
+ * the ring memory is fixed.
+ */
+#define SDLCLAY_UPLOAD_RING_PAGES 4
+#define SDLCLAY_UPLOAD_RING_PAGE_SIZE 1024
+
+typedef enum SDLCLAY_GlyphPolicy {
+	// Glyphs still rasterizing are left blank, the frame is drawn again once they are uploaded
+	SDLCLAY_GLYPH_POLICY_PLACEHOLDER,
+	// Missing glyphs of the frame are rasterized in parallel and waited for before drawing
+	SDLCLAY_GLYPH_POLICY_BLOCK,
+} SDLCLAY_GlyphPolicy;
+
+/**
+ * Glyph workers open up to SDLCLAY_GLYPH_WORKER_FONTS font sizes each, and at most
+ * SDLCLAY_GLYPH_QUEUE_CAPACITY glyphs wait for them, further ones are rasterized
+ * on the calling thread
+ */
+#define SDLCLAY_GLYPH_WORKERS_MAX 8
+#define SDLCLAY_GLYPH_WORKER_FONTS 8
+#define SDLCLAY_GLYPH_QUEUE_CAPACITY 1024
+
+/**
+ * Rasterize the missing glyphs of the glyph atlas on worker threads, uploaded at the start
+ * of SDLCLAY_RenderCommands. Only fonts added with SDLCLAY_AddFont, workers open their own
+ * instances from its file bytes. Disabled by default, glyphs are rasterized when drawn.
+ *
+ * @param worker_count Number of threads, 0 to stop them
+ * @param policy What to draw for glyphs not rasterized yet
+ * @return false if no worker could be started
+ */
+bool SDLCLAY_SetGlyphWorkers(int worker_count, SDLCLAY_GlyphPolicy policy);
+
+typedef enum SDLCLAY_TextMode {
+	// Glyphs packed in shared atlas pages, text drawn as batched quads
+	SDLCLAY_TEXT_MODE_GLYPH_ATLAS,
+	// One cached texture per (string, font, size, color)
+	SDLCLAY_TEXT_MODE_STRING_CACHE,
+	// Glyph atlas where every size is drawn, with linear filtering, from glyphs rasterized at the
+	// power of two size at or above it, clamped to SDLCLAY_SCALABLE_TEXT_MIN_SIZE..SDLCLAY_SCALABLE_TEXT_MAX_SIZE.
+	// It only lets many sizes share a few font instances and their glyphs: the render scale is not
+	// taken into account, text at other sizes is softer than in SDLCLAY_TEXT_MODE_GLYPH_ATLAS, and
+	// sizes under half the minimum or over the maximum are scaled by more than a factor of two.
+	// Only meant for UIs using many different sizes, where it is worth trading sharpness for memory.
+	SDLCLAY_TEXT_MODE_SCALABLE,
+} SDLCLAY_TextMode;
+
+#define SDLCLAY_SCALABLE_TEXT_MIN_SIZE 16
+#define SDLCLAY_SCALABLE_TEXT_MAX_SIZE 128
+
+/**
+ * Select how text commands are rendered, default to SDLCLAY_TEXT_MODE_GLYPH_ATLAS.
+ * Resets the Clay text measurement cache when the mode changes.
+ * @param mode Text rendering mode to use
+ */
+void SDLCLAY_SetTextMode(SDLCLAY_TextMode mode);
+
+/**
+ * @return The current text mode
+ */
+SDLCLAY_TextMode SDLCLAY_GetTextMode();
+
+typedef enum SDLCLAY_RenderMode {
+	// Commands are composed in an offscreen target blended over the current target
+	SDLCLAY_RENDER_MODE_OFFSCREEN,
+	// Commands are drawn straight into the current target, saving a full-screen
+	// composite pass. Offscreen textures are only used by features needing isolation.
+	SDLCLAY_RENDER_MODE_DIRECT,
+} SDLCLAY_RenderMode;
+
+/**
+ * Select where commands are drawn, default to SDLCLAY_RENDER_MODE_OFFSCREEN
+ * @param mode Render mode to use
+ */
+void SDLCLAY_SetRenderMode(SDLCLAY_RenderMode mode);
+
+/**
+ * @return The current render mode
+ */
+SDLCLAY_RenderMode SDLCLAY_GetRenderMode();
+
+/**
+ * In SDLCLAY_RENDER_MODE_OFFSCREEN, commands are composed in a target kept alive across frames.
+ * It grows in steps of SDLCLAY_RENDER_TARGET_GRANULARITY pixels and shrinks once the
+ * output has been less than half its size for SDLCLAY_RENDER_TARGET_SHRINK_DELAY frames.
+ */
+#define SDLCLAY_RENDER_TARGET_GRANULARITY 256
+#define SDLCLAY_RENDER_TARGET_SHRINK_DELAY 60
+
+/**
+ * Release the composition target, it will be recreated by the next SDLCLAY_RenderCommands.
+ * Also called by SDLCLAY_Quit.
+ */
+void SDLCLAY_ReleaseRenderTarget();
+
 /**
  * Render Clay commands using SDL3 renderer.
  *
@@ -94,4 +484,23 @@ Clay_Dimensions SDLCLAY_MeasureText(Clay_StringSlice text, Clay_TextElementConfi
  */
 void SDLCLAY_RenderCommands(SDL_Renderer *renderer, Clay_RenderCommandArray *commands_array);
 
+/**
+ * Compare the commands with the last ones drawn by SDLCLAY_RenderCommands, using a hash
+ * of their types, bounding boxes, configs, strings and textures, along with the output size,
+ * render scale and SDLCLAY settings. When unchanged, rendering and presenting can be skipped.
+ *
+ * Content of the textures is not hashed, call SDLCLAY_InvalidateFrame when it changes
+ * or when the window content is lost.
+ *
+ * @param renderer The SDL_Renderer the commands would be rendered with.
+ * @param commands_array The array of render commands to compare.
+ * @return true if the commands would draw the same frame as the last one
+ */
+bool SDLCLAY_IsFrameUnchanged(SDL_Renderer *renderer, Clay_RenderCommandArray *commands_array);
+
+/**
+ * Force the next SDLCLAY_IsFrameUnchanged to report a change
+ */
+void SDLCLAY_InvalidateFrame();
+
 #endif //CLAY_RENDERER_SDL3_H
\ No newline at end of file
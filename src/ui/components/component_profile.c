@@ -4,23 +4,24 @@
 #include "../colors.h"
 
 struct HoverEvent {
-	SDL_Texture** img1;
-	SDL_Texture** img2;
+	SDLCLAY_Image** img1;
+	SDLCLAY_Image** img2;
 };
 
 static void onHover(Clay_ElementId elementId, Clay_PointerData pointerInfo, intptr_t userData) {
 	if (pointerInfo.state == CLAY_POINTER_DATA_RELEASED_THIS_FRAME) {
 		if (userData) {
 			const struct HoverEvent * event = (struct HoverEvent *)userData;
-			SDL_Texture* temp = *event->img1;
+			SDLCLAY_Image* temp = *event->img1;
 			*event->img1 = *event->img2;
 			*event->img2 = temp;
 		}
 	}
 }
 
-void Profile_component(SDL_Texture** IMG1, SDL_Texture** IMG2, Arena* FRAME_ARENA) {
+void Profile_component(SDLCLAY_Image** IMG1, SDLCLAY_Image** IMG2, Arena* FRAME_ARENA) {
 	const Clay_ElementDeclaration ProfilePictureOuterConfig = {
+		.id = CLAY_ID("ProfileCard"),
 		.layout = {
 			.sizing = {
 				.width = CLAY_SIZING_GROW(0)
@@ -37,13 +38,13 @@ void Profile_component(SDL_Texture** IMG1, SDL_Texture** IMG2, Arena* FRAME_AREN
 		.id = CLAY_ID("ProfilePicture"),
 		.layout = {
 			.sizing = {
-				.width = CLAY_SIZING_FIXED(60),
-				.height = CLAY_SIZING_FIXED(60)
+				.width = CLAY_SIZING_FIXED(PROFILE_PICTURE_SIZE),
+				.height = CLAY_SIZING_FIXED(PROFILE_PICTURE_SIZE)
 			}
 		},
 		.image = {
 			.imageData = *IMG1,
-			.sourceDimensions = {60, 60},
+			.sourceDimensions = {PROFILE_PICTURE_SIZE, PROFILE_PICTURE_SIZE},
 		}
 	};
 
@@ -2,7 +2,11 @@
 #define PROFILE_COMPONENTS_H
 
 #include "../../appstate.h"
+#include "../../renderer/SDL3CLAY.h"
 
-void Profile_component(SDL_Texture** IMG1, SDL_Texture** IMG2, Arena* FRAME_ARENA);
+// Size the profile pictures are drawn at
+#define PROFILE_PICTURE_SIZE 60
+
+void Profile_component(SDLCLAY_Image** IMG1, SDLCLAY_Image** IMG2, Arena* FRAME_ARENA);
 
 #endif //PROFILE_COMPONENTS_H
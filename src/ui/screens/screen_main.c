@@ -11,11 +11,12 @@
 #include "../components/component_profile.h"
 #include "../components/component_sidebar_item.h"
 #include "../../common/memory_leak.h"
+#include "../../renderer/SDL3CLAY.h"
 
 typedef struct Data {
     Arena *arena;
-    SDL_Texture* img_profile1;
-    SDL_Texture* img_profile2;
+    SDLCLAY_Image* img_profile1;
+    SDLCLAY_Image* img_profile2;
 } Data;
 
 static void* init(AppState *APP) {
@@ -24,8 +25,16 @@ static void* init(AppState *APP) {
     const size_t arena_size = Arena_requiredSize(512);
     DATA->arena = Arena_init(ml_malloc(arena_size), arena_size);
 
-    DATA->img_profile1 = IMG_LoadTexture(APP->renderer, "assets/avatar.jpg");
-    DATA->img_profile2 = IMG_LoadTexture(APP->renderer, "assets/avatar2.png");
+    SDL_Surface* avatar1 = IMG_Load("assets/avatar.jpg");
+    DATA->img_profile1 = SDLCLAY_CreateImageScaled(APP->renderer, avatar1, PROFILE_PICTURE_SIZE, PROFILE_PICTURE_SIZE, 1);
+    SDL_DestroySurface(avatar1);
+    SDL_Surface* avatar2 = IMG_Load("assets/avatar2.png");
+    DATA->img_profile2 = SDLCLAY_CreateImageScaled(APP->renderer, avatar2, PROFILE_PICTURE_SIZE, PROFILE_PICTURE_SIZE, 1);
+    SDL_DestroySurface(avatar2);
+
+    // The profile card only changes when its picture is swapped
+    SDLCLAY_SetLayerCached(CLAY_ID("ProfileCard"), true);
+    SDLCLAY_SetScrollCached(CLAY_ID("SideBar"), true);
 
     return DATA;
 }
@@ -95,8 +104,10 @@ void update(AppState *APP, void *screen_state) {
 
 static void destroy(AppState *APP, void *screen_state) {
     const Data* DATA = screen_state;
-    SDL_DestroyTexture(DATA->img_profile1);
-    SDL_DestroyTexture(DATA->img_profile2);
+    SDLCLAY_SetLayerCached(CLAY_ID("ProfileCard"), false);
+    SDLCLAY_SetScrollCached(CLAY_ID("SideBar"), false);
+    SDLCLAY_DestroyImage(DATA->img_profile1);
+    SDLCLAY_DestroyImage(DATA->img_profile2);
     ml_free(DATA->arena);
     ml_free(screen_state);
 }
@@ -9,15 +9,18 @@
 #include "../components/component_profile.h"
 #include "../components/component_sidebar_item.h"
 #include "../../common/memory_leak.h"
+#include "../../renderer/SDL3CLAY.h"
 
 typedef struct Data {
-    SDL_Texture* img_profile1;
+    SDLCLAY_Image* img_profile1;
 } Data;
 
 static void* init(AppState *APP) {
     Data* DATA = ml_malloc(sizeof(Data));
 
-    DATA->img_profile1 = IMG_LoadTexture(APP->renderer, "assets/avatar2.png");
+    SDL_Surface* avatar1 = IMG_Load("assets/avatar2.png");
+    DATA->img_profile1 = SDLCLAY_CreateImageScaled(APP->renderer, avatar1, PROFILE_PICTURE_SIZE, PROFILE_PICTURE_SIZE, 1);
+    SDL_DestroySurface(avatar1);
 
     return DATA;
 }
@@ -75,7 +78,7 @@ static void update(AppState *APP, void *screen_state) {
 
 static void destroy(AppState *APP, void *screen_state) {
     Data* DATA = screen_state;
-    SDL_DestroyTexture(DATA->img_profile1);
+    SDLCLAY_DestroyImage(DATA->img_profile1);
     ml_free(DATA);
 }
 
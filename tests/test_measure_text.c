@@ -0,0 +1,88 @@
+/**
+ * Check the ASCII measurement fast path of the renderer against TTF_MeasureString
+ *
+ * Usage: test_measure_text [font path]
+ */
+
+#define CLAY_IMPLEMENTATION
+#include <clay.h>
+
+// Built with the renderer to reach its internal measurement functions
+#include "../src/renderer/SDL3CLAY.c"
+
+static const char* STRINGS[] = {
+	"Clay - UI Library",
+	"Sidebar Item 1",
+	"Hello World!",
+	"AVAWAY To Ty Yo LT Wa",
+	"fjord office affluent",
+	"iiiiiiiiii WWWWWWWWWW",
+	"{[(|)]} /\\ _^_ `~'",
+	"0123456789 +-*/=%$#@&",
+	" leading and trailing ",
+	" ",
+};
+
+static const float SIZES[] = {8, 12, 15, 16, 24, 32, 48, 64, 128};
+
+static int CheckString(const int font_id, const float size, const char* chars, const int length) {
+	TTF_Font* font = SDLCLAY_GetFont(font_id, size);
+	FontMetrics* metrics = FontMetrics_get(font_id, size, font);
+	const Clay_StringSlice text = {.length = length, .chars = chars, .baseChars = chars};
+
+	int width = 0;
+	int expected = 0;
+	if (!FontMetrics_measureAscii(metrics, font, text, &width)) {
+		SDL_Log("\"%.*s\" (size %g) was not measured by the fast path", length, chars, (double) size);
+		return 1;
+	}
+	if (!TTF_MeasureString(font, chars, (size_t) length, 0, &expected, NULL)) {
+		SDL_Log("TTF_MeasureString failed for \"%.*s\": %s", length, chars, SDL_GetError());
+		return 1;
+	}
+	if (width != expected) {
+		SDL_Log("\"%.*s\" (size %g) measured %d wide instead of %d", length, chars, (double) size, width, expected);
+		return 1;
+	}
+	return 0;
+}
+
+int main(int argc, char* argv[]) {
+	const char* font_path = argc > 1 ? argv[1] : "assets/Roboto-Regular.ttf";
+
+	if (!TTF_Init()) {
+		SDL_Log("Couldn't initialize SDL_ttf: %s", SDL_GetError());
+		return 1;
+	}
+
+	const int font_id = SDLCLAY_AddFont(font_path, 16);
+	if (font_id < 0) {
+		SDL_Log("Couldn't load %s", font_path);
+		TTF_Quit();
+		return 1;
+	}
+
+	int failures = 0;
+	int checks = 0;
+	for (size_t s = 0; s < SDL_arraysize(SIZES); s++) {
+		for (size_t i = 0; i < SDL_arraysize(STRINGS); i++) {
+			failures += CheckString(font_id, SIZES[s], STRINGS[i], (int) SDL_strlen(STRINGS[i]));
+			checks++;
+		}
+
+		// Every pair of printable characters, covering the kerning of the fast path
+		for (int first = SDLCLAY_ASCII_FIRST; first <= SDLCLAY_ASCII_LAST; first++) {
+			for (int second = SDLCLAY_ASCII_FIRST; second <= SDLCLAY_ASCII_LAST; second++) {
+				const char pair[2] = {(char) first, (char) second};
+				failures += CheckString(font_id, SIZES[s], pair, 2);
+				checks++;
+			}
+		}
+	}
+
+	SDL_Log("%d of %d measurements differ from TTF_MeasureString", failures, checks);
+
+	SDLCLAY_Quit();
+	TTF_Quit();
+	return failures == 0 ? 0 : 1;
+}